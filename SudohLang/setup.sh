@@ -1,6 +1,6 @@
 # make static library
-g++ -c sudoh/variable.cpp sudoh/sudoh.cpp sudoh/runtime_ex.cpp
-ar rcs libsudoh.a variable.o sudoh.o runtime_ex.o
-rm -f variable.o sudoh.o runtime_ex.o
+g++ -c sudoh/variable.cpp sudoh/sudoh.cpp sudoh/runtime_ex.cpp sudoh/memo.cpp sudoh/profiler.cpp sudoh/line_counter.cpp sudoh/sampler.cpp sudoh/thread_pool.cpp sudoh/parallel.cpp sudoh/task.cpp sudoh/channel.cpp sudoh/ref.cpp sudoh/simd.cpp sudoh/matrix.cpp sudoh/file_io.cpp sudoh/csv.cpp sudoh/json.cpp sudoh/snapshot.cpp sudoh/rope.cpp sudoh/pattern.cpp sudoh/object.cpp sudoh/heap.cpp
+ar rcs libsudoh.a variable.o sudoh.o runtime_ex.o memo.o profiler.o line_counter.o sampler.o thread_pool.o parallel.o task.o channel.o ref.o simd.o matrix.o file_io.o csv.o json.o snapshot.o rope.o pattern.o object.o heap.o
+rm -f variable.o sudoh.o runtime_ex.o memo.o profiler.o line_counter.o sampler.o thread_pool.o parallel.o task.o channel.o ref.o simd.o matrix.o file_io.o csv.o json.o snapshot.o rope.o pattern.o object.o heap.o
 
 g++ -I ./transpiler/ transpiler/sudoht.cpp transpiler/name_manager.cpp transpiler/parser.cpp transpiler/token_iter.cpp transpiler/transpiled_buf.cpp -o sudoht
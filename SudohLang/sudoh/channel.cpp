@@ -0,0 +1,146 @@
+#include "channel.h"
+#include "thread_pool.h"
+#include "runtime_ex.h"
+#include <thread>
+
+// the address of this is different for each thread, and identifies the thread using a side of a channel
+static thread_local const char threadMarker = 0;
+// the user of a side of a channel once more than one thread has used it
+static const char sharedMarker = 0;
+
+// a use of a side of a channel by the current thread, which takes the side's lock unless the thread is
+// the only one to have used the side. The first use by a second thread marks the side as shared, and then
+// waits for the only user to finish any use it began without the lock. Both threads write and then read
+// (in sequentially consistent order) the values the other reads and writes, so that at least one of them
+// sees that the other is using the side
+class SideUse
+{
+	Channel::Side& side;
+	std::unique_lock<std::mutex> lock;
+	bool alone;
+
+public:
+	SideUse(Channel::Side& side) : side(side), alone(false)
+	{
+		const void* me = &threadMarker;
+		const void* user = side.user.load();
+		if (user == nullptr && side.user.compare_exchange_strong(user, me))
+		{
+			user = me;
+		}
+
+		if (user == me)
+		{
+			side.active.store(true);
+			if (side.user.load() == me)
+			{
+				alone = true;
+				return;
+			}
+			side.active.store(false);
+		}
+		else if (user != &sharedMarker)
+		{
+			side.user.store(&sharedMarker);
+			while (side.active.load())
+			{
+				std::this_thread::yield();
+			}
+		}
+		lock = std::unique_lock<std::mutex>(side.lock);
+	}
+
+	~SideUse()
+	{
+		if (alone)
+		{
+			side.active.store(false);
+		}
+	}
+};
+
+Channel::Channel(size_t cap) : capacity(cap), slots(cap), head(0), tail(0), closed(false), waiting(0) {}
+
+// waits until a condition holds
+void Channel::waitUntil(const std::function<bool()>& ready)
+{
+	if (ready())
+	{
+		return;
+	}
+
+	ThreadPool::instance().beginBlocking();
+	std::unique_lock<std::mutex> lock(waitLock);
+	waiting++;
+	changed.wait(lock, ready);
+	waiting--;
+	lock.unlock();
+	mergeQueuedRefs();
+}
+
+void Channel::notify()
+{
+	if (waiting.load() != 0)
+	{
+		std::lock_guard<std::mutex> lock(waitLock);
+		changed.notify_all();
+	}
+}
+
+void Channel::send(Variable value)
+{
+	while (true)
+	{
+		waitUntil([this]() { return closed.load() || tail.load() - head.load() < capacity; });
+
+		SideUse use(senders);
+		if (closed.load())
+		{
+			runtimeException("cannot send to a closed channel");
+		}
+		size_t t = tail.load();
+		// another sender may have filled the space while this one waited for the lock
+		if (t - head.load() == capacity)
+		{
+			continue;
+		}
+
+		slots[t % capacity] = std::move(value);
+		tail.store(t + 1);
+		notify();
+		return;
+	}
+}
+
+// receives the oldest value sent; null once the channel is closed and all values have been received
+Variable Channel::receive()
+{
+	while (true)
+	{
+		waitUntil([this]() { return closed.load() || tail.load() != head.load(); });
+
+		SideUse use(receivers);
+		size_t h = head.load();
+		if (tail.load() == h)
+		{
+			if (closed.load())
+			{
+				return Variable();
+			}
+			// another receiver took the value while this one waited for the lock
+			continue;
+		}
+
+		Variable value = std::move(slots[h % capacity]);
+		head.store(h + 1);
+		notify();
+		return value;
+	}
+}
+
+void Channel::close()
+{
+	closed.store(true);
+	std::lock_guard<std::mutex> lock(waitLock);
+	changed.notify_all();
+}
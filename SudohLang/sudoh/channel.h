@@ -0,0 +1,57 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include "variable.h"
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// bounded queue of values passed between tasks. Values are stored in a ring buffer which one sender
+// and one receiver can use at the same time without locking. Each side (senders or receivers) is used
+// without locking for as long as a single thread uses it; once a second thread uses a side, every use of
+// that side takes its lock. Values are moved into and out of the buffer, so sending a list or object
+// transfers the reference to it. Sending to a full channel or receiving from an empty one waits until
+// space or a value is available
+struct Channel
+{
+	const size_t capacity;
+
+	Channel(size_t cap);
+	void send(Variable value);
+	Variable receive();
+	void close();
+
+	// the senders or the receivers of a channel
+	struct Side
+	{
+		// the only thread which has used the side, or a marker once more than one thread has
+		std::atomic<const void*> user;
+		// whether the only thread which has used the side is using it without its lock
+		std::atomic<bool> active;
+		std::mutex lock;
+
+		Side() : user(nullptr), active(false) {}
+	};
+
+private:
+	std::vector<Variable> slots;
+	// number of values ever received/sent; head is only changed by receivers and tail by senders
+	std::atomic<size_t> head;
+	std::atomic<size_t> tail;
+	std::atomic<bool> closed;
+
+	Side senders;
+	Side receivers;
+
+	// senders/receivers waiting for space/values sleep on this until another side makes a change
+	std::mutex waitLock;
+	std::condition_variable changed;
+	std::atomic<int> waiting;
+
+	void waitUntil(const std::function<bool()>& ready);
+	void notify();
+};
+
+#endif
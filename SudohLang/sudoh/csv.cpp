@@ -0,0 +1,285 @@
+#include "csv.h"
+#include "object.h"
+#include "file_io.h"
+#include "simd.h"
+#include "runtime_ex.h"
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <algorithm>
+
+// text of a field of a CSV file, which usually points into the mapped file; 'text' is null for a field
+// missing from the end of a short row
+struct Field
+{
+	const char* text;
+	size_t length;
+};
+
+// returns whether the text of a field is a number, and the number if so
+static bool parseNumber(const Field& field, double& out)
+{
+	char first = field.text[0];
+	if (!(first >= '0' && first <= '9') && first != '-' && first != '.')
+	{
+		return false;
+	}
+	const char* end = field.text + field.length;
+	auto result = std::from_chars(field.text, end, out);
+	return result.ec == std::errc() && result.ptr == end;
+}
+
+// fields of a column read so far. A column is numeric until a field which is neither a number nor
+// empty is read; numbers are parsed as they are read, and the texts of fields are kept in case the
+// column turns out not to be numeric
+struct Column
+{
+	std::string name;
+	bool numeric = true;
+	std::vector<Field> fields;
+	std::vector<double> numbers;
+
+	void add(const Field& field)
+	{
+		fields.push_back(field);
+		if (!numeric)
+		{
+			return;
+		}
+		double n = 0;
+		if (field.text && field.length != 0 && !parseNumber(field, n))
+		{
+			numeric = false;
+			std::vector<double>().swap(numbers);
+			return;
+		}
+		numbers.push_back(n);
+	}
+
+	// returns the fields as a list; empty fields of numeric columns and missing fields are null
+	Variable toList() const
+	{
+		Variable::List list;
+		list.reserve(fields.size());
+		for (size_t i = 0; i < fields.size(); i++)
+		{
+			const Field& f = fields[i];
+			if (!f.text || (numeric && f.length == 0))
+			{
+				list.emplace_back();
+			}
+			else if (numeric)
+			{
+				list.emplace_back(numbers[i]);
+			}
+			else
+			{
+				list.emplace_back(std::string(f.text, f.length));
+			}
+		}
+		return Variable::ListRef(std::move(list));
+	}
+};
+
+// reads the fields of a CSV file one at a time, in a single pass over the file
+class CSVParser
+{
+	const std::string& path;
+	const char* pos;
+	const char* end;
+	char delimiter;
+	size_t line;
+	// texts of quoted fields which contained escaped quotes ("") and so are not in the mapped file
+	std::deque<std::string> unescaped;
+
+	void error(const std::string& message)
+	{
+		runtimeException(message + " on line " + std::to_string(line) + " of file '" + path + "'");
+	}
+
+	// reads a field beginning with a quote, which ends at the next quote not followed by another quote
+	Field quotedField()
+	{
+		const char* begin = pos + 1;
+		const char* search = begin;
+		bool escaped = false;
+		const char* quote;
+		while (true)
+		{
+			quote = (const char*)memchr(search, '"', end - search);
+			if (!quote)
+			{
+				error("unterminated quoted field");
+			}
+			if (quote + 1 < end && quote[1] == '"')
+			{
+				escaped = true;
+				search = quote + 2;
+				continue;
+			}
+			break;
+		}
+		pos = quote + 1;
+		if (pos + 1 < end && pos[0] == '\r' && pos[1] == '\n')
+		{
+			pos++;
+		}
+		if (pos != end && *pos != delimiter && *pos != '\n')
+		{
+			error("unexpected character after quoted field");
+		}
+		if (!escaped)
+		{
+			return { begin, (size_t)(quote - begin) };
+		}
+
+		std::string text;
+		for (const char* c = begin; c < quote; c++)
+		{
+			text += *c;
+			if (*c == '"')
+			{
+				c++;
+			}
+		}
+		unescaped.push_back(std::move(text));
+		return { unescaped.back().data(), unescaped.back().length() };
+	}
+
+public:
+	CSVParser(const std::string& path, const MappedFile& file, char delimiter) :
+		path(path), pos(file.begin()), end(file.end()), delimiter(delimiter), line(1) {}
+
+	// skips empty lines before a row; returns whether there is another row
+	bool nextRow()
+	{
+		while (pos != end && (*pos == '\n' || (*pos == '\r' && pos + 1 < end && pos[1] == '\n')))
+		{
+			pos += *pos == '\n' ? 1 : 2;
+			line++;
+		}
+		return pos != end;
+	}
+
+	// reads the next field of the current row; returns whether it was the last field of the row
+	bool nextField(Field& field)
+	{
+		if (pos != end && *pos == '"')
+		{
+			field = quotedField();
+		}
+		else
+		{
+			const char* fieldEnd = simdFindEither(pos, end, delimiter, '\n');
+			field = { pos, (size_t)(fieldEnd - pos) };
+			if (fieldEnd != end && *fieldEnd == '\n' && field.length != 0 && fieldEnd[-1] == '\r')
+			{
+				field.length--;
+			}
+			pos = fieldEnd;
+		}
+
+		if (pos == end)
+		{
+			return true;
+		}
+		if (*pos++ == delimiter)
+		{
+			return false;
+		}
+		line++;
+		return true;
+	}
+
+	size_t lineNumber() const { return line; }
+};
+
+// reads a CSV file into an object mapping the name of each column to a list of its fields. Columns in
+// which every field is a number or empty are lists of numbers (with null for empty fields)
+Variable readCSV(const std::string& path, const CSVOptions& options)
+{
+	MappedFile file(path);
+	CSVParser parser(path, file, options.delimiter);
+
+	// the first row gives the number of columns, and their names if there is a header
+	std::vector<Field> firstRow;
+	if (parser.nextRow())
+	{
+		Field field;
+		bool last;
+		do
+		{
+			last = parser.nextField(field);
+			firstRow.push_back(field);
+		} while (!last);
+	}
+	std::vector<std::string> names;
+	for (size_t i = 0; i < firstRow.size(); i++)
+	{
+		names.push_back(options.header ? std::string(firstRow[i].text, firstRow[i].length) : std::to_string(i));
+	}
+
+	// which of the columns read each field of a row belongs to, if any
+	std::vector<Column> columns;
+	std::vector<int> columnOf(names.size(), -1);
+	const std::vector<std::string>& selected = options.columns.empty() ? names : options.columns;
+	for (const std::string& name : selected)
+	{
+		size_t field = std::find(names.begin(), names.end(), name) - names.begin();
+		if (field == names.size())
+		{
+			runtimeException("column '" + name + "' does not exist in file '" + path + "'");
+		}
+		if (columnOf[field] != -1 || std::find(names.begin() + field + 1, names.end(), name) != names.end())
+		{
+			runtimeException("column name '" + name + "' appears more than once in file '" + path + "'");
+		}
+		columnOf[field] = (int)columns.size();
+		columns.push_back(Column());
+		columns.back().name = name;
+	}
+
+	size_t rowLine = 1;
+	auto addField = [&](const Field& field, size_t index) {
+		if (index >= names.size())
+		{
+			runtimeException("line " + std::to_string(rowLine) + " of file '" + path +
+				"' has more fields than the first row");
+		}
+		if (columnOf[index] != -1)
+		{
+			columns[columnOf[index]].add(field);
+		}
+	};
+
+	if (!options.header)
+	{
+		for (size_t i = 0; i < firstRow.size(); i++)
+		{
+			addField(firstRow[i], i);
+		}
+	}
+	while (parser.nextRow())
+	{
+		rowLine = parser.lineNumber();
+		size_t index = 0;
+		Field field;
+		bool last;
+		do
+		{
+			last = parser.nextField(field);
+			addField(field, index++);
+		} while (!last);
+		for (; index < names.size(); index++)
+		{
+			addField({ nullptr, 0 }, index);
+		}
+	}
+
+	Variable::Object result;
+	for (const Column& column : columns)
+	{
+		result.insert(Variable(column.name), column.toList());
+	}
+	return Variable::ObjectRef(std::move(result));
+}
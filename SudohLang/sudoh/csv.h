@@ -0,0 +1,18 @@
+#ifndef CSV_H
+#define CSV_H
+
+#include "variable.h"
+
+// options of 'readCSV'
+struct CSVOptions
+{
+	char delimiter = ',';
+	// whether the first row holds the names of the columns; otherwise columns are named "0", "1", ...
+	bool header = true;
+	// names of the columns to read; all columns are read if empty
+	std::vector<std::string> columns;
+};
+
+Variable readCSV(const std::string& path, const CSVOptions& options);
+
+#endif
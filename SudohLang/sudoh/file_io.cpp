@@ -0,0 +1,225 @@
+#include "file_io.h"
+#include "runtime_ex.h"
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// size of the buffer of a file opened by 'appendFile'
+constexpr size_t APPEND_BUFFER_SIZE = 1 << 16;
+
+// files opened by 'appendFile', which are kept open with a large buffer so that many small appends are
+// written to the file together. A file is closed (writing its buffer) before it is otherwise read or
+// written, and all are closed when the program ends
+struct Appenders
+{
+	std::mutex lock;
+	std::map<std::string, FILE*> files;
+
+	~Appenders()
+	{
+		for (auto& f : files)
+		{
+			fclose(f.second);
+		}
+	}
+};
+
+static Appenders appenders;
+
+// closes the file at 'path' if it was opened by 'appendFile'
+static void closeAppender(const std::string& path)
+{
+	std::lock_guard<std::mutex> guard(appenders.lock);
+	auto f = appenders.files.find(path);
+	if (f != appenders.files.end())
+	{
+		fclose(f->second);
+		appenders.files.erase(f);
+	}
+}
+
+// +--------------------------+
+// |   MappedFile and lines   |
+// +--------------------------+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path) : data(nullptr), size(0), file(INVALID_HANDLE_VALUE), mapping(nullptr)
+{
+	closeAppender(path);
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER fileSize;
+	if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize))
+	{
+		runtimeException("could not open file '" + path + "' for reading");
+	}
+	size = (size_t)fileSize.QuadPart;
+	if (size == 0)
+	{
+		return;
+	}
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	data = mapping ? (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!data)
+	{
+		runtimeException("could not read file '" + path + "'");
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (data)
+	{
+		UnmapViewOfFile(data);
+	}
+	if (mapping)
+	{
+		CloseHandle(mapping);
+	}
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file);
+	}
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path) : data(nullptr), size(0)
+{
+	closeAppender(path);
+	int fd = open(path.c_str(), O_RDONLY);
+	struct stat info;
+	if (fd == -1 || fstat(fd, &info) == -1 || !S_ISREG(info.st_mode))
+	{
+		if (fd != -1)
+		{
+			close(fd);
+		}
+		runtimeException("could not open file '" + path + "' for reading");
+	}
+	size = (size_t)info.st_size;
+	if (size != 0)
+	{
+		void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED)
+		{
+			close(fd);
+			runtimeException("could not read file '" + path + "'");
+		}
+		// files are mostly read from beginning to end, so the OS should read ahead
+		madvise(mapped, size, MADV_SEQUENTIAL);
+		data = (const char*)mapped;
+	}
+	// the mapping stays valid after the file is closed
+	close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+	if (data)
+	{
+		munmap((void*)data, size);
+	}
+}
+
+#endif
+
+// returns the beginning of the line after the one beginning at 'line'
+const char* FileLines::nextLine(const char* line, const char* end)
+{
+	const char* newline = (const char*)memchr(line, '\n', end - line);
+	return newline ? newline + 1 : end;
+}
+
+// returns the line beginning at 'line' without its line ending
+std::string FileLines::lineAt(const char* line, const char* end)
+{
+	const char* lineEnd = nextLine(line, end);
+	if (lineEnd != line && lineEnd[-1] == '\n')
+	{
+		lineEnd--;
+	}
+	if (lineEnd != line && lineEnd[-1] == '\r')
+	{
+		lineEnd--;
+	}
+	return std::string(line, lineEnd);
+}
+
+// +-------------------------------+
+// |   Reading and writing files   |
+// +-------------------------------+
+
+std::string readFile(const std::string& path)
+{
+	MappedFile file(path);
+	return std::string(file.begin(), file.end());
+}
+
+void writeFile(const std::string& path, const char* data, size_t size)
+{
+	closeAppender(path);
+	FILE* f = fopen(path.c_str(), "wb");
+	if (!f)
+	{
+		runtimeException("could not open file '" + path + "' for writing");
+	}
+	bool written = fwrite(data, 1, size, f) == size;
+	if (fclose(f) != 0 || !written)
+	{
+		runtimeException("could not write to file '" + path + "'");
+	}
+}
+
+void writeFile(const std::string& path, const std::string& contents)
+{
+	writeFile(path, contents.data(), contents.size());
+}
+
+void appendFile(const std::string& path, const char* data, size_t size)
+{
+	bool opened = true, written = false;
+	{
+		std::lock_guard<std::mutex> guard(appenders.lock);
+		FILE*& f = appenders.files[path];
+		if (!f && (f = fopen(path.c_str(), "ab")))
+		{
+			setvbuf(f, nullptr, _IOFBF, APPEND_BUFFER_SIZE);
+		}
+		if (!f)
+		{
+			appenders.files.erase(path);
+			opened = false;
+		}
+		else
+		{
+			written = fwrite(data, 1, size, f) == size;
+		}
+	}
+	if (!opened)
+	{
+		runtimeException("could not open file '" + path + "' for writing");
+	}
+	if (!written)
+	{
+		runtimeException("could not write to file '" + path + "'");
+	}
+}
+
+void appendFile(const std::string& path, const std::string& contents)
+{
+	appendFile(path, contents.data(), contents.size());
+}
@@ -0,0 +1,45 @@
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <string>
+#include <cstddef>
+
+// read-only view of the contents of a file mapped into memory; the operating system reads parts of the
+// file only when they are used, so even very large files can be mapped
+class MappedFile
+{
+	const char* data;
+	size_t size;
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#endif
+
+public:
+	MappedFile(const std::string& path);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	const char* begin() const { return data; }
+	const char* end() const { return data + size; }
+};
+
+// the lines of a file, as output by 'lines' and iterated over by 'for each' one line at a time
+struct FileLines
+{
+	MappedFile file;
+
+	FileLines(const std::string& path) : file(path) {}
+
+	static const char* nextLine(const char* line, const char* end);
+	static std::string lineAt(const char* line, const char* end);
+};
+
+std::string readFile(const std::string& path);
+void writeFile(const std::string& path, const char* data, size_t size);
+void writeFile(const std::string& path, const std::string& contents);
+void appendFile(const std::string& path, const char* data, size_t size);
+void appendFile(const std::string& path, const std::string& contents);
+
+#endif
@@ -0,0 +1,153 @@
+#include "heap.h"
+#include "runtime_ex.h"
+#include <algorithm>
+#include <cmath>
+
+// a handle is the generation of a slot in the upper bits and the slot in the lower 32 bits
+
+double Heap::push(double priority, Variable value)
+{
+	uint32_t slot;
+	if (!freeSlots.empty())
+	{
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+		slots[slot].value = std::move(value);
+	}
+	else
+	{
+		slot = (uint32_t)slots.size();
+		slots.push_back({ std::move(value), 0, 0 });
+	}
+
+	entries.emplace_back();
+	siftUp(entries.size() - 1, { priority, slot });
+	return (double)(((uint64_t)slots[slot].generation << 32) | slot);
+}
+
+// removes and returns the value with the lowest priority
+Variable Heap::pop()
+{
+	if (entries.empty())
+	{
+		runtimeException("cannot pop from an empty heap");
+	}
+
+	Slot& top = slots[entries[0].slot];
+	Variable value = std::move(top.value);
+	top.value = Variable();
+	top.position = SIZE_MAX;
+	top.generation = (top.generation + 1) % GENERATIONS;
+	freeSlots.push_back(entries[0].slot);
+
+	Entry last = entries.back();
+	entries.pop_back();
+	if (!entries.empty())
+	{
+		siftDown(0, last);
+	}
+	return value;
+}
+
+// returns the value with the lowest priority
+const Variable& Heap::peek() const
+{
+	if (entries.empty())
+	{
+		runtimeException("cannot peek at an empty heap");
+	}
+	return slots[entries[0].slot].value;
+}
+
+// lowers the priority of the value a handle refers to, which must still be in the heap
+void Heap::decrease(double handle, double priority)
+{
+	if (!(handle >= 0 && handle < (double)((uint64_t)GENERATIONS << 32)) || handle != std::floor(handle))
+	{
+		runtimeException("invalid heap handle " + Variable(handle).toString());
+	}
+	uint64_t h = (uint64_t)handle;
+	uint32_t slot = (uint32_t)h;
+	if (slot >= slots.size() || slots[slot].position == SIZE_MAX || slots[slot].generation != (uint32_t)(h >> 32))
+	{
+		runtimeException("heap handle " + Variable(handle).toString() + " does not refer to a value in the heap");
+	}
+
+	size_t position = slots[slot].position;
+	if (priority > entries[position].priority)
+	{
+		runtimeException("cannot increase the priority of a value in a heap from " +
+			Variable(entries[position].priority).toString() + " to " + Variable(priority).toString());
+	}
+	siftUp(position, { priority, slot });
+}
+
+Variable::List Heap::sorted() const
+{
+	std::vector<Entry> order(entries);
+	std::sort(order.begin(), order.end(), [](const Entry& left, const Entry& right)
+	{
+		return left.priority < right.priority;
+	});
+
+	Variable::List values;
+	values.reserve(order.size());
+	for (const Entry& entry : order)
+	{
+		values.push_back(slots[entry.slot].value);
+	}
+	return values;
+}
+
+// puts an entry at a position in the array, recording the position in its slot
+void Heap::place(size_t position, Entry entry)
+{
+	entries[position] = entry;
+	slots[entry.slot].position = position;
+}
+
+// moves an entry from a position towards the root until its parent's priority is no higher than its own.
+// Parents are moved down into the hole left by the entry, which is placed once its position is found
+void Heap::siftUp(size_t position, Entry entry)
+{
+	while (position > 0)
+	{
+		size_t parent = (position - 1) / ARITY;
+		if (!(entry.priority < entries[parent].priority))
+		{
+			break;
+		}
+		place(position, entries[parent]);
+		position = parent;
+	}
+	place(position, entry);
+}
+
+// moves an entry from a position away from the root until none of its children has a lower priority
+void Heap::siftDown(size_t position, Entry entry)
+{
+	size_t n = entries.size();
+	while (true)
+	{
+		size_t first = position * ARITY + 1;
+		if (first >= n)
+		{
+			break;
+		}
+		size_t lowest = first;
+		for (size_t child = first + 1; child < std::min(first + ARITY, n); child++)
+		{
+			if (entries[child].priority < entries[lowest].priority)
+			{
+				lowest = child;
+			}
+		}
+		if (!(entries[lowest].priority < entry.priority))
+		{
+			break;
+		}
+		place(position, entries[lowest]);
+		position = lowest;
+	}
+	place(position, entry);
+}
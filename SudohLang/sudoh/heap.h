@@ -0,0 +1,54 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include "variable.h"
+#include <vector>
+#include <cstdint>
+
+// priority queue of values ordered by number priorities, lowest priority first. Entries are kept in a
+// 4-ary heap (shallower than a binary heap, with the children of an entry next to each other in memory)
+// whose array holds only the priority of each entry and the slot its value is in, so that moving an entry
+// copies 16 bytes rather than a Variable. Values stay in their slots from when they are pushed until they
+// are popped; a slot freed by a pop is reused by a later push, with its generation counted up so that the
+// handles of earlier values do not refer to the new one
+struct Heap
+{
+	size_t size() const { return entries.size(); }
+
+	// adds a value, returning the handle to it which its priority may be decreased with
+	double push(double priority, Variable value);
+	Variable pop();
+	const Variable& peek() const;
+	void decrease(double handle, double priority);
+	// the values in order of priority, without removing them
+	Variable::List sorted() const;
+
+private:
+	static const size_t ARITY = 4;
+	// generations are kept small enough that every handle is exactly representable by a number
+	static const uint32_t GENERATIONS = 1 << 20;
+
+	struct Entry
+	{
+		double priority;
+		uint32_t slot;
+	};
+
+	struct Slot
+	{
+		Variable value;
+		// index of the slot's entry, or SIZE_MAX if the slot is free
+		size_t position;
+		uint32_t generation;
+	};
+
+	std::vector<Entry> entries;
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+
+	void place(size_t position, Entry entry);
+	void siftUp(size_t position, Entry entry);
+	void siftDown(size_t position, Entry entry);
+};
+
+#endif
@@ -0,0 +1,444 @@
+#include "json.h"
+#include "object.h"
+#include "simd.h"
+#include "runtime_ex.h"
+#include <charconv>
+#include <cmath>
+#include <algorithm>
+
+// lists and objects nested more deeply than this are not parsed, so that parsing cannot overflow the stack
+constexpr size_t MAX_JSON_DEPTH = 1000;
+
+// +-------------------+
+// |   JSON parsing    |
+// +-------------------+
+
+// parses JSON text in a single pass, building lists and objects directly as their elements are parsed
+class JSONParser
+{
+	const char* begin;
+	const char* pos;
+	const char* end;
+	size_t depth;
+
+	void error(const std::string& message)
+	{
+		size_t line = 1 + std::count(begin, pos, '\n');
+		runtimeException("invalid JSON: " + message + " on line " + std::to_string(line));
+	}
+
+	void skipWhitespace()
+	{
+		while (pos != end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t'))
+		{
+			pos++;
+		}
+	}
+
+	// consumes a character (after any whitespace) if it is next
+	bool consume(char c)
+	{
+		skipWhitespace();
+		if (pos != end && *pos == c)
+		{
+			pos++;
+			return true;
+		}
+		return false;
+	}
+
+	void expect(char c)
+	{
+		if (!consume(c))
+		{
+			error(std::string("expected '") + c + "'");
+		}
+	}
+
+	// consumes a word (e.g. 'true') if it is next
+	bool consumeWord(const char* word, size_t length)
+	{
+		if ((size_t)(end - pos) >= length && std::equal(word, word + length, pos))
+		{
+			pos += length;
+			return true;
+		}
+		return false;
+	}
+
+	// parses 4 hexadecimal digits of a \u escape
+	unsigned hexDigits()
+	{
+		unsigned code = 0;
+		if (end - pos < 4 || std::from_chars(pos, pos + 4, code, 16).ptr != pos + 4)
+		{
+			error("invalid \\u escape in string");
+		}
+		pos += 4;
+		return code;
+	}
+
+	static void appendUTF8(std::string& out, unsigned code)
+	{
+		if (code < 0x80)
+		{
+			out += (char)code;
+		}
+		else if (code < 0x800)
+		{
+			out += (char)(0xC0 | (code >> 6));
+			out += (char)(0x80 | (code & 0x3F));
+		}
+		else if (code < 0x10000)
+		{
+			out += (char)(0xE0 | (code >> 12));
+			out += (char)(0x80 | ((code >> 6) & 0x3F));
+			out += (char)(0x80 | (code & 0x3F));
+		}
+		else
+		{
+			out += (char)(0xF0 | (code >> 18));
+			out += (char)(0x80 | ((code >> 12) & 0x3F));
+			out += (char)(0x80 | ((code >> 6) & 0x3F));
+			out += (char)(0x80 | (code & 0x3F));
+		}
+	}
+
+	// parses a string after its opening quote; characters up to the next quote or backslash are copied at once
+	std::string string()
+	{
+		std::string out;
+		while (true)
+		{
+			const char* special = simdFindEither(pos, end, '"', '\\');
+			if (special == end)
+			{
+				error("unterminated string");
+			}
+			for (const char* c = pos; c < special; c++)
+			{
+				if ((unsigned char)*c < 0x20)
+				{
+					pos = c;
+					error("control character in string");
+				}
+			}
+			out.append(pos, special);
+			pos = special + 1;
+			if (*special == '"')
+			{
+				return out;
+			}
+
+			if (pos == end)
+			{
+				error("unterminated string");
+			}
+			switch (*pos++)
+			{
+			case '"': out += '"'; break;
+			case '\\': out += '\\'; break;
+			case '/': out += '/'; break;
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u':
+			{
+				unsigned code = hexDigits();
+				// characters outside the basic multilingual plane are written as a pair of surrogates
+				if (code >= 0xD800 && code < 0xDC00 && consumeWord("\\u", 2))
+				{
+					unsigned low = hexDigits();
+					if (low < 0xDC00 || low >= 0xE000)
+					{
+						error("invalid surrogate pair in string");
+					}
+					code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+				}
+				appendUTF8(out, code);
+				break;
+			}
+			default:
+				pos--;
+				error("invalid escape in string");
+			}
+		}
+	}
+
+	double number()
+	{
+		const char* start = pos;
+		if (pos != end && *pos == '-')
+		{
+			pos++;
+		}
+		if (pos == end || *pos < '0' || *pos > '9')
+		{
+			error(start == pos ? "unexpected character" : "invalid number");
+		}
+		double num;
+		auto result = std::from_chars(start, end, num);
+		if (result.ec != std::errc())
+		{
+			error("invalid number");
+		}
+		pos = result.ptr;
+		return num;
+	}
+
+	Variable list()
+	{
+		Variable::List list;
+		if (!consume(']'))
+		{
+			do
+			{
+				list.push_back(value());
+			} while (consume(','));
+			expect(']');
+		}
+		return Variable::ListRef(std::move(list));
+	}
+
+	Variable object()
+	{
+		Variable::Object object;
+		if (!consume('}'))
+		{
+			do
+			{
+				expect('"');
+				Variable key = string();
+				expect(':');
+				// a field appearing more than once has its last value
+				object[key] = value();
+			} while (consume(','));
+			expect('}');
+		}
+		return Variable::ObjectRef(std::move(object));
+	}
+
+public:
+	JSONParser(const std::string& text) : begin(text.data()), pos(text.data()), end(text.data() + text.length()), depth(0) {}
+
+	Variable value()
+	{
+		skipWhitespace();
+		if (pos == end)
+		{
+			error("unexpected end of text");
+		}
+		char c = *pos;
+		if (c == '"')
+		{
+			pos++;
+			return string();
+		}
+		if (c == '[' || c == '{')
+		{
+			if (++depth > MAX_JSON_DEPTH)
+			{
+				error("lists and objects nested too deeply");
+			}
+			pos++;
+			Variable container = c == '[' ? list() : object();
+			depth--;
+			return container;
+		}
+		if (consumeWord("true", 4))
+		{
+			return true;
+		}
+		if (consumeWord("false", 5))
+		{
+			return false;
+		}
+		if (consumeWord("null", 4))
+		{
+			return Variable();
+		}
+		return number();
+	}
+
+	void finish()
+	{
+		skipWhitespace();
+		if (pos != end)
+		{
+			error("unexpected text after value");
+		}
+	}
+};
+
+Variable parseJSON(const std::string& text)
+{
+	JSONParser parser(text);
+	Variable parsed = parser.value();
+	parser.finish();
+	return parsed;
+}
+
+// +-------------------+
+// |   JSON writing    |
+// +-------------------+
+
+// writes variables as JSON text into a single buffer
+class JSONWriter
+{
+	std::string out;
+	// the lists and objects which contain the value being written, for detecting a list or object containing itself
+	std::vector<const void*> containers;
+
+	void enter(const void* container)
+	{
+		if (std::find(containers.begin(), containers.end(), container) != containers.end())
+		{
+			runtimeException("cannot convert a list or object which contains itself to JSON");
+		}
+		containers.push_back(container);
+	}
+
+	void number(double num)
+	{
+		if (!std::isfinite(num))
+		{
+			runtimeException("cannot convert number " + Variable(num).toString() + " to JSON");
+		}
+		char buffer[32];
+		// integers (as most numbers in Sudoh are) are written without a fraction; other numbers are written
+		// with as few digits as will be read back as the same number
+		auto result = num == std::trunc(num) && std::abs(num) < 1e15 ?
+			std::to_chars(buffer, buffer + sizeof(buffer), (long long)num) :
+			std::to_chars(buffer, buffer + sizeof(buffer), num);
+		out.append(buffer, result.ptr);
+	}
+
+	void string(const std::string& str)
+	{
+		static const char HEX[] = "0123456789abcdef";
+		out += '"';
+		size_t copied = 0;
+		for (size_t i = 0; i < str.length(); i++)
+		{
+			unsigned char c = str[i];
+			if (c >= 0x20 && c != '"' && c != '\\')
+			{
+				continue;
+			}
+			out.append(str, copied, i - copied);
+			copied = i + 1;
+			switch (c)
+			{
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				out += "\\u00";
+				out += HEX[c >> 4];
+				out += HEX[c & 0xF];
+			}
+		}
+		out.append(str, copied, std::string::npos);
+		out += '"';
+	}
+
+public:
+	void value(const Variable& var)
+	{
+		switch (var.type)
+		{
+		case Type::null:
+			out += "null";
+			break;
+		case Type::boolean:
+			out += var.val.boolVal ? "true" : "false";
+			break;
+		case Type::number:
+			number(var.val.numVal);
+			break;
+		case Type::string:
+		case Type::charRef:
+			string(var.str());
+			break;
+		case Type::list:
+		{
+			enter(var.val.listRef.get());
+			out += '[';
+			bool first = true;
+			for (const Variable& e : *var.val.listRef)
+			{
+				if (!first)
+				{
+					out += ',';
+				}
+				value(e);
+				first = false;
+			}
+			out += ']';
+			containers.pop_back();
+			break;
+		}
+		case Type::object:
+		{
+			enter(var.val.objRef.get());
+			out += '{';
+			bool first = true;
+			for (const auto& field : *var.val.objRef)
+			{
+				if (!first)
+				{
+					out += ',';
+				}
+				if (!field.first.isString())
+				{
+					runtimeException("cannot convert an object with key " + field.first.toString() +
+						" which is not a string to JSON");
+				}
+				string(field.first.str());
+				out += ':';
+				value(field.second);
+				first = false;
+			}
+			out += '}';
+			containers.pop_back();
+			break;
+		}
+		case Type::matrix:
+		{
+			// matrices are written as a list of rows
+			const Matrix& m = *var.val.matrixRef;
+			out += '[';
+			for (size_t r = 0; r < m.rows; r++)
+			{
+				out += r == 0 ? "[" : ",[";
+				for (size_t c = 0; c < m.cols; c++)
+				{
+					if (c != 0)
+					{
+						out += ',';
+					}
+					number(m.at(r, c));
+				}
+				out += ']';
+			}
+			out += ']';
+			break;
+		}
+		default:
+			runtimeException("cannot convert type " + var.typeString() + " to JSON");
+		}
+	}
+
+	std::string& text() { return out; }
+};
+
+std::string toJSON(const Variable& var)
+{
+	JSONWriter writer;
+	writer.value(var);
+	return std::move(writer.text());
+}
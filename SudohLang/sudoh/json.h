@@ -0,0 +1,9 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include "variable.h"
+
+Variable parseJSON(const std::string& text);
+std::string toJSON(const Variable& var);
+
+#endif
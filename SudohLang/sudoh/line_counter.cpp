@@ -0,0 +1,111 @@
+#include "line_counter.h"
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+
+// execution counters of a single Sudoh source file
+struct CountedFile
+{
+	std::string sourceFile;
+	const LineCount* counts;
+	std::set<int> countedLines;
+};
+
+static std::vector<CountedFile>& countedFiles()
+{
+	static std::vector<CountedFile> files;
+	return files;
+}
+
+// writes the line counts of all source files to the file specified by SUDOH_LINE_COUNTS_OUTPUT; the
+// number of hottest lines summarized is specified by SUDOH_HOT_LINES
+static void writeLineCounts()
+{
+	const char* output = getenv("SUDOH_LINE_COUNTS_OUTPUT");
+	const char* hot = getenv("SUDOH_HOT_LINES");
+	size_t numHot = hot ? strtoul(hot, nullptr, 10) : 10;
+
+	std::ofstream out(output ? output : "sudoh_lines.txt");
+
+	// summary of the most executed lines of all files
+	struct HotLine
+	{
+		unsigned long long count;
+		const CountedFile* file;
+		int line;
+	};
+	std::vector<HotLine> hotLines;
+	for (const CountedFile& f : countedFiles())
+	{
+		for (int line : f.countedLines)
+		{
+			hotLines.push_back({ f.counts[line].load(), &f, line });
+		}
+	}
+	numHot = std::min(numHot, hotLines.size());
+	std::partial_sort(hotLines.begin(), hotLines.begin() + numHot, hotLines.end(), [](const HotLine& a, const HotLine& b) {
+		return a.count > b.count;
+	});
+
+	out << "Hottest lines:\n";
+	for (size_t i = 0; i < numHot; i++)
+	{
+		out << std::setw(16) << hotLines[i].count << "  " << hotLines[i].file->sourceFile << ":" << hotLines[i].line << "\n";
+	}
+
+	// listing of each source file annotated with the execution count of each statement line; lines
+	// which are not statements are marked with '-' and statements which were never executed with '#####'
+	for (const CountedFile& f : countedFiles())
+	{
+		out << "\n" << f.sourceFile << ":\n";
+
+		std::ifstream source(f.sourceFile);
+		if (!source)
+		{
+			out << "(source file could not be opened)\n";
+			for (int line : f.countedLines)
+			{
+				out << std::setw(16) << f.counts[line].load() << ":" << std::setw(5) << line << "\n";
+			}
+			continue;
+		}
+
+		std::string text;
+		for (int line = 1; std::getline(source, text); line++)
+		{
+			if (!text.empty() && text.back() == '\r')
+			{
+				text.pop_back();
+			}
+
+			out << std::setw(16);
+			if (f.countedLines.count(line) == 0)
+			{
+				out << "-";
+			}
+			else if (f.counts[line].load() == 0)
+			{
+				out << "#####";
+			}
+			else
+			{
+				out << f.counts[line].load();
+			}
+			out << ":" << std::setw(5) << line << ":" << text << "\n";
+		}
+	}
+}
+
+LineCounter::LineCounter(const char* sourceFile, const LineCount* counts, const int* countedLines, size_t numCounted)
+{
+	std::vector<CountedFile>& files = countedFiles();
+	if (files.empty())
+	{
+		atexit(writeLineCounts);
+	}
+	files.push_back({ sourceFile, counts, std::set<int>(countedLines, countedLines + numCounted) });
+}
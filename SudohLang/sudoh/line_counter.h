@@ -0,0 +1,56 @@
+#ifndef LINE_COUNTER_H
+#define LINE_COUNTER_H
+
+#include "variable.h"
+#include <cstddef>
+#include <atomic>
+
+// execution counter of a line; atomic, as lines inside of parallel loops and tasks are run by many threads
+typedef std::atomic<unsigned long long> LineCount;
+
+// counts an execution of a line. The counts are only read once the program exits, so the increment does
+// not need to be ordered with anything else
+inline void countLine(LineCount& count)
+{
+	count.fetch_add(1, std::memory_order_relaxed);
+}
+
+// registers the execution counters of the statement lines of a Sudoh source file. When the program
+// exits, an annotated listing of all registered source files is written along with their hottest lines
+class LineCounter
+{
+public:
+	LineCounter(const char* sourceFile, const LineCount* counts, const int* countedLines, size_t numCounted);
+};
+
+// the collection of a 'for each' loop, which counts an execution of the loop's line each time the loop
+// checks whether it has reached the end, as the condition of any other loop is counted; 'for each e in x'
+// is transpiled to 'for (var v_e : CountedIterations(lineCounts[n], v_x))' when lines are counted
+class CountedIterations
+{
+	LineCount& count;
+	Variable collection;
+
+public:
+	class iterator
+	{
+		LineCount& count;
+		Variable::VariableIterator it;
+
+	public:
+		iterator(LineCount& count, Variable::VariableIterator it) : count(count), it(it) {}
+		void operator++() { ++it; }
+		Variable operator*() { return *it; }
+		bool operator!=(const iterator& other)
+		{
+			countLine(count);
+			return it != other.it;
+		}
+	};
+
+	CountedIterations(LineCount& count, Variable collection) : count(count), collection(collection) {}
+	iterator begin() { return iterator(count, collection.begin()); }
+	iterator end() { return iterator(count, collection.end()); }
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "matrix.h"
+#include "simd.h"
+#include "runtime_ex.h"
+#include <algorithm>
+
+// side length of the square blocks that matrices are split into by 'product' and 'transposed', so that
+// the parts of the matrices being worked on stay in cache (64 x 64 numbers is 32KB)
+constexpr size_t BLOCK_SIZE = 64;
+
+// returns the size of a matrix as e.g. "2 x 3"
+static std::string sizeString(const Matrix& m)
+{
+	return std::to_string(m.rows) + " x " + std::to_string(m.cols);
+}
+
+Matrix::Matrix(size_t rows, size_t cols, double fill) : rows(rows), cols(cols), data(rows * cols, fill) {}
+
+// returns the position in 'data' of an element, which must be inside the matrix
+size_t Matrix::assertIndex(size_t row, size_t col) const
+{
+	if (row >= rows || col >= cols)
+	{
+		runtimeException("specified element [" + std::to_string(row) + "][" + std::to_string(col) +
+			"] out of bounds of matrix (size " + sizeString(*this) + ")");
+	}
+	return row * cols + col;
+}
+
+void Matrix::assertSameSize(const Matrix& other, const std::string& operation) const
+{
+	if (rows != other.rows || cols != other.cols)
+	{
+		runtimeException("illegal operation '" + operation + "' between matrices of sizes " + sizeString(*this) +
+			" and " + sizeString(other));
+	}
+}
+
+Matrix Matrix::transposed() const
+{
+	Matrix out(cols, rows);
+	for (size_t r0 = 0; r0 < rows; r0 += BLOCK_SIZE)
+	{
+		for (size_t c0 = 0; c0 < cols; c0 += BLOCK_SIZE)
+		{
+			size_t rEnd = std::min(r0 + BLOCK_SIZE, rows), cEnd = std::min(c0 + BLOCK_SIZE, cols);
+			for (size_t r = r0; r < rEnd; r++)
+			{
+				for (size_t c = c0; c < cEnd; c++)
+				{
+					out.at(c, r) = at(r, c);
+				}
+			}
+		}
+	}
+	return out;
+}
+
+// returns the matrix product of this matrix and another. Rows of the output are built by adding rows of
+// 'other' scaled by elements of this matrix, so the innermost loop runs along contiguous rows; only one
+// block of 'other' is used at a time, so it stays in cache while it is used for every row of the output
+Matrix Matrix::product(const Matrix& other) const
+{
+	if (cols != other.rows)
+	{
+		runtimeException("cannot multiply matrix of size " + sizeString(*this) + " by matrix of size " +
+			sizeString(other));
+	}
+	Matrix out(rows, other.cols);
+	for (size_t k0 = 0; k0 < cols; k0 += BLOCK_SIZE)
+	{
+		for (size_t c0 = 0; c0 < other.cols; c0 += BLOCK_SIZE)
+		{
+			size_t kEnd = std::min(k0 + BLOCK_SIZE, cols), width = std::min(BLOCK_SIZE, other.cols - c0);
+			for (size_t r = 0; r < rows; r++)
+			{
+				double* outRow = &out.data[r * out.cols + c0];
+				for (size_t k = k0; k < kEnd; k++)
+				{
+					simdAxpy(at(r, k), &other.data[k * other.cols + c0], outRow, width);
+				}
+			}
+		}
+	}
+	return out;
+}
+
+// returns the matrix made by applying an elementwise kernel (e.g. simdAdd) to this matrix and another
+// of the same size
+Matrix Matrix::combined(const Matrix& other, void (*kernel)(const double*, const double*, double*, size_t)) const
+{
+	Matrix out(rows, cols);
+	kernel(data.data(), other.data.data(), out.data.data(), data.size());
+	return out;
+}
+
+Matrix Matrix::scaled(double factor) const
+{
+	Matrix out(rows, cols);
+	simdScale(data.data(), factor, out.data.data(), data.size());
+	return out;
+}
+
+Matrix Matrix::divided(double divisor) const
+{
+	Matrix out(rows, cols);
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		out.data[i] = data[i] / divisor;
+	}
+	return out;
+}
@@ -0,0 +1,30 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+// matrix of numbers stored contiguously row after row; unlike a list of lists, reading an element
+// does not copy a Variable and neighbouring elements of a row are next to each other in memory
+struct Matrix
+{
+	size_t rows, cols;
+	std::vector<double> data;
+
+	Matrix(size_t rows, size_t cols, double fill = 0);
+
+	double& at(size_t row, size_t col) { return data[row * cols + col]; }
+	double at(size_t row, size_t col) const { return data[row * cols + col]; }
+
+	size_t assertIndex(size_t row, size_t col) const;
+	void assertSameSize(const Matrix& other, const std::string& operation) const;
+
+	Matrix transposed() const;
+	Matrix product(const Matrix& other) const;
+	Matrix combined(const Matrix& other, void (*kernel)(const double*, const double*, double*, size_t)) const;
+	Matrix scaled(double factor) const;
+	Matrix divided(double divisor) const;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include "memo.h"
+#include <algorithm>
+
+std::atomic<size_t> MemoTable::limit(0);
+
+size_t MemoTable::KeyHash::operator()(const Key& key) const
+{
+	size_t hash = key.size();
+	for (const Variable& e : key)
+	{
+		hash ^= e.keyHash() + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	}
+	return hash;
+}
+
+bool MemoTable::KeyEqual::operator()(const Key& left, const Key& right) const
+{
+	if (left.size() != right.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < left.size(); i++)
+	{
+		if (!left[i].keyEquals(right[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// list of all tables in existence, so that they may all be cleared/inspected at once
+std::vector<MemoTable*>& MemoTable::allTables()
+{
+	static std::vector<MemoTable*> tables;
+	return tables;
+}
+
+std::mutex& MemoTable::allTablesLock()
+{
+	static std::mutex lock;
+	return lock;
+}
+
+MemoTable::MemoTable(const std::string name, int params) : procName(name), numParams(params), hits(0), misses(0)
+{
+	std::lock_guard<std::mutex> tablesLock(allTablesLock());
+	allTables().push_back(this);
+}
+
+MemoTable::~MemoTable()
+{
+	std::lock_guard<std::mutex> tablesLock(allTablesLock());
+	std::vector<MemoTable*>& tables = allTables();
+	tables.erase(std::remove(tables.begin(), tables.end(), this), tables.end());
+}
+
+// finds the cached output for a set of parameter values; returns false if there is none
+bool MemoTable::find(const Key& key, Variable& output)
+{
+	std::lock_guard<std::mutex> tableLock(lock);
+	auto e = cache.find(key);
+	if (e == cache.end())
+	{
+		misses++;
+		return false;
+	}
+	hits++;
+	output = e->second;
+	return true;
+}
+
+// caches the output for a set of parameter values and returns it
+Variable MemoTable::store(const Key& key, const Variable& output)
+{
+	std::lock_guard<std::mutex> tableLock(lock);
+	size_t maxEntries = limit.load(std::memory_order_relaxed);
+	if (maxEntries != 0)
+	{
+		while (cache.size() >= maxEntries && !insertionOrder.empty())
+		{
+			cache.erase(*insertionOrder.front());
+			insertionOrder.pop_front();
+		}
+	}
+
+	auto inserted = cache.emplace(key, output);
+	if (inserted.second)
+	{
+		insertionOrder.push_back(&inserted.first->first);
+	}
+	return output;
+}
+
+void MemoTable::clear()
+{
+	std::lock_guard<std::mutex> tableLock(lock);
+	cache.clear();
+	insertionOrder.clear();
+}
+
+void MemoTable::clearAll()
+{
+	std::lock_guard<std::mutex> tablesLock(allTablesLock());
+	for (MemoTable* e : allTables())
+	{
+		e->clear();
+	}
+}
+
+void MemoTable::stats(size_t& totalHits, size_t& totalMisses, size_t& totalEntries)
+{
+	std::lock_guard<std::mutex> tablesLock(allTablesLock());
+	totalHits = totalMisses = totalEntries = 0;
+	for (MemoTable* e : allTables())
+	{
+		std::lock_guard<std::mutex> tableLock(e->lock);
+		totalHits += e->hits;
+		totalMisses += e->misses;
+		totalEntries += e->cache.size();
+	}
+}
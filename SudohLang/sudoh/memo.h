@@ -0,0 +1,60 @@
+#ifndef MEMO_H
+#define MEMO_H
+
+#include "variable.h"
+#include <unordered_map>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+// cache of the outputs of a memoized procedure, keyed on the values of its parameters. One table
+// is created for each memoized procedure the first time that the procedure is called. Tables may
+// be used by multiple threads in parallel loops, so all accesses are made while holding a lock
+class MemoTable
+{
+public:
+	typedef std::vector<Variable> Key;
+
+private:
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+	struct KeyEqual
+	{
+		bool operator()(const Key& left, const Key& right) const;
+	};
+
+	const std::string procName;
+	const int numParams;
+
+	std::unordered_map<Key, Variable, KeyHash, KeyEqual> cache;
+	// keys of cache in order of insertion; oldest entries are evicted first when the cache size limit is reached
+	std::deque<const Key*> insertionOrder;
+
+	size_t hits;
+	size_t misses;
+
+	std::mutex lock;
+
+	static std::vector<MemoTable*>& allTables();
+	static std::mutex& allTablesLock();
+
+public:
+	// maximum number of entries kept by each table; 0 for no limit. It may be set while memoized procedures
+	// are called on other threads, which only need to see it eventually, so it is accessed with relaxed ordering
+	static std::atomic<size_t> limit;
+
+	MemoTable(const std::string name, int params);
+	~MemoTable();
+
+	bool find(const Key& key, Variable& output);
+	Variable store(const Key& key, const Variable& output);
+	void clear();
+
+	static void clearAll();
+	static void stats(size_t& totalHits, size_t& totalMisses, size_t& totalEntries);
+};
+
+#endif
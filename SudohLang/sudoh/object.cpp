@@ -0,0 +1,190 @@
+#include "object.h"
+#include "runtime_ex.h"
+#include <mutex>
+#include <algorithm>
+
+// +------------+
+// |   Shapes   |
+// +------------+
+
+Shape::Shape(std::initializer_list<const char*> keys, uint32_t id) : id(id)
+{
+	for (const char* key : keys)
+	{
+		this->keys.emplace_back(std::string(key));
+		names.emplace_back(key);
+		order.push_back((uint32_t)order.size());
+	}
+	std::sort(order.begin(), order.end(), [this](uint32_t left, uint32_t right)
+	{
+		return names[left] < names[right];
+	});
+}
+
+// returns the shape with the given keys, creating it the first time it is needed. Shapes are never freed,
+// as there is one for each object literal at most
+const Shape* Shape::get(std::initializer_list<const char*> keys)
+{
+	static std::mutex shapesLock;
+	static std::map<std::vector<std::string>, const Shape*> shapes;
+
+	std::lock_guard<std::mutex> guard(shapesLock);
+	const Shape*& shape = shapes[std::vector<std::string>(keys.begin(), keys.end())];
+	if (!shape)
+	{
+		shape = new Shape(keys, (uint32_t)shapes.size());
+	}
+	return shape;
+}
+
+// searches the keys in order for a key
+int Shape::slot(const Variable& key) const
+{
+	const std::string* k;
+	if (!Variable::stringCheck(key, k))
+	{
+		runtimeException("object field identifier must be a string; got type '" + key.typeString() + "'");
+	}
+	auto found = std::lower_bound(order.begin(), order.end(), *k, [this](uint32_t slot, const std::string& k)
+	{
+		return names[slot] < k;
+	});
+	if (found == order.end() || names[*found] != *k)
+	{
+		return -1;
+	}
+	return (int)*found;
+}
+
+// +-------------+
+// |   Objects   |
+// +-------------+
+
+Variable::Object::Object() : shape(nullptr) {}
+
+Variable::Object::Object(std::initializer_list<std::pair<const Variable, Variable>> fields) :
+	shape(nullptr), fields(fields) {}
+
+Variable::Object::Object(const Shape* shape, std::initializer_list<Variable> values) : shape(shape), slots(values) {}
+
+// moves the values of an object with a shape into a map, so that fields can be added or removed
+void Variable::Object::toDictionary()
+{
+	for (size_t slot = 0; slot < slots.size(); slot++)
+	{
+		fields.emplace(shape->key(slot), std::move(slots[slot]));
+	}
+	slots = std::vector<Variable>();
+	shape = nullptr;
+}
+
+Variable* Variable::Object::find(const Variable& key)
+{
+	if (shape)
+	{
+		int slot = shape->slot(key);
+		return slot == -1 ? nullptr : &slots[slot];
+	}
+	auto found = fields.find(key);
+	return found == fields.end() ? nullptr : &found->second;
+}
+
+// finds a field by its cached slot if this object has the shape the field was last found in, and otherwise
+// searches the shape's keys and caches the slot found
+Variable* Variable::Object::find(const FieldKey& field)
+{
+	if (!shape)
+	{
+		return find(field.key);
+	}
+	uint64_t cached = field.cache.load(std::memory_order_relaxed);
+	if ((uint32_t)(cached >> 32) == shape->id)
+	{
+		return &slots[(uint32_t)cached];
+	}
+	int slot = shape->slot(field.key);
+	if (slot == -1)
+	{
+		return nullptr;
+	}
+	field.cache.store(((uint64_t)shape->id << 32) | (uint32_t)slot, std::memory_order_relaxed);
+	return &slots[slot];
+}
+
+Variable& Variable::Object::operator[](const Variable& key)
+{
+	if (Variable* value = find(key))
+	{
+		return *value;
+	}
+	if (shape)
+	{
+		toDictionary();
+	}
+	return fields[key];
+}
+
+Variable& Variable::Object::operator[](const FieldKey& field)
+{
+	if (Variable* value = find(field))
+	{
+		return *value;
+	}
+	return (*this)[field.key];
+}
+
+bool Variable::Object::insert(const Variable& key, const Variable& value)
+{
+	if (find(key))
+	{
+		return false;
+	}
+	(*this)[key] = value;
+	return true;
+}
+
+bool Variable::Object::erase(const Variable& key)
+{
+	if (!find(key))
+	{
+		return false;
+	}
+	if (shape)
+	{
+		toDictionary();
+	}
+	fields.erase(key);
+	return true;
+}
+
+// objects with a shape are iterated in the order of their keys by index; others by their map
+
+Variable::Object::iterator::iterator(const Object* object, bool begin) :
+	object(object), index(begin ? 0 : object->slots.size()), it(begin ? object->fields.begin() : object->fields.end()) {}
+
+std::pair<const Variable&, const Variable&> Variable::Object::iterator::operator*() const
+{
+	if (object->shape)
+	{
+		uint32_t slot = object->shape->slotInOrder(index);
+		return { object->shape->key(slot), object->slots[slot] };
+	}
+	return { it->first, it->second };
+}
+
+void Variable::Object::iterator::operator++()
+{
+	if (object->shape)
+	{
+		index++;
+	}
+	else
+	{
+		it++;
+	}
+}
+
+bool Variable::Object::iterator::operator!=(const iterator& other) const
+{
+	return object->shape ? index != other.index : it != other.it;
+}
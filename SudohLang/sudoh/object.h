@@ -0,0 +1,98 @@
+#ifndef OBJECT_H
+#define OBJECT_H
+
+#include "variable.h"
+#include <map>
+#include <atomic>
+#include <utility>
+#include <initializer_list>
+
+// the keys of objects made by object literals with the same keys in the same order, e.g.
+// '{ "val" <- v, "next" <- null }'. A shape is created once for each set of keys and shared by every object
+// which has it; such objects hold their values in an array in the order of the shape's keys (their slots)
+class Shape
+{
+	std::vector<Variable> keys;
+	std::vector<std::string> names;
+	// slots in the order of their keys, which is the order objects are iterated in
+	std::vector<uint32_t> order;
+
+	Shape(std::initializer_list<const char*> keys, uint32_t id);
+
+public:
+	// unique for each shape, and never 0
+	const uint32_t id;
+
+	static const Shape* get(std::initializer_list<const char*> keys);
+
+	size_t size() const { return keys.size(); }
+	const Variable& key(size_t slot) const { return keys[slot]; }
+	uint32_t slotInOrder(size_t index) const { return order[index]; }
+	// returns the slot of a key, or -1 if the shape does not have it
+	int slot(const Variable& key) const;
+};
+
+// an index into an object by a string literal e.g. 'node["next"]', which remembers the shape of the last
+// object it found the field in and the field's slot (a monomorphic inline cache), so that the field of an
+// object of the same shape is found without a search. Each such index in a program has its own FieldKey
+struct FieldKey
+{
+	const Variable key;
+	// the id of the shape in the upper 32 bits and the slot in the lower, read and written at once
+	mutable std::atomic<uint64_t> cache;
+
+	explicit FieldKey(const char* key) : key(std::string(key)), cache(0) {}
+
+	operator const Variable&() const { return key; }
+};
+
+// fields of an object. An object made by an object literal with string literal keys has the literal's
+// shape, and holds its values in an array; adding or removing a field changes it to a map from keys to
+// values (dictionary mode), as do objects made in any other way
+class Variable::Object
+{
+	typedef std::map<Variable, Variable, ObjectComp> Fields;
+
+	const Shape* shape;
+	std::vector<Variable> slots;
+	Fields fields;
+
+	void toDictionary();
+
+public:
+	class iterator
+	{
+		const Object* object;
+		size_t index;
+		Fields::const_iterator it;
+
+	public:
+		iterator(const Object* object, bool begin);
+		std::pair<const Variable&, const Variable&> operator*() const;
+		void operator++();
+		bool operator!=(const iterator& other) const;
+	};
+
+	Object();
+	Object(std::initializer_list<std::pair<const Variable, Variable>> fields);
+	Object(const Shape* shape, std::initializer_list<Variable> values);
+
+	bool shaped() const { return shape != nullptr; }
+	size_t size() const { return shape ? slots.size() : fields.size(); }
+
+	// returns the value of a field, or null if the object does not have it
+	Variable* find(const Variable& key);
+	Variable* find(const FieldKey& field);
+	// returns the value of a field, adding it (as null) if the object does not have it
+	Variable& operator[](const Variable& key);
+	Variable& operator[](const FieldKey& field);
+	// adds a field if the object does not have it, returning whether it was added
+	bool insert(const Variable& key, const Variable& value);
+	// removes a field, returning whether the object had it
+	bool erase(const Variable& key);
+
+	iterator begin() const { return iterator(this, true); }
+	iterator end() const { return iterator(this, false); }
+};
+
+#endif
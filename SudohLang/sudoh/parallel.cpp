@@ -0,0 +1,117 @@
+#include "parallel.h"
+#include "thread_pool.h"
+#include "task.h"
+#include "runtime_ex.h"
+#include <algorithm>
+
+// number of tasks created per thread; more tasks than threads lets workers balance uneven iterations
+constexpr size_t TASKS_PER_THREAD = 4;
+
+ParallelReductions::ParallelReductions(size_t numReductions) : values(numReductions), used(numReductions, false) {}
+
+// accumulates a value of a reduction; '-' reductions accumulate the sum of the values to be subtracted
+void ParallelReductions::add(size_t reduction, char op, const Variable& value)
+{
+	Variable& acc = values[reduction];
+	if (!used[reduction])
+	{
+		acc = value;
+		used[reduction] = true;
+	}
+	else if (op == '*')
+	{
+		acc *= value;
+	}
+	else
+	{
+		acc += value;
+	}
+}
+
+void ParallelReductions::applyTo(const ParallelReduction& reduction, size_t index) const
+{
+	if (!used[index])
+	{
+		return;
+	}
+	switch (reduction.op)
+	{
+	case '+':
+		reduction.target += values[index];
+		break;
+	case '-':
+		reduction.target -= values[index];
+		break;
+	case '*':
+		reduction.target *= values[index];
+		break;
+	}
+}
+
+std::mutex& ParallelStore::storeLock()
+{
+	static std::mutex lock;
+	return lock;
+}
+
+ParallelStore::ParallelStore() : lock(storeLock()) {}
+
+// runs the body of a 'parallel for each' loop for each element of a list, splitting the list into
+// contiguous ranges of elements which are run as tasks by the thread pool. The thread running the loop
+// runs the ranges no other thread has started, most recently submitted first, and then waits for the rest;
+// it does not run other tasks while waiting, as those may only be able to finish once the loop has
+void parallelForEach(const Variable& list, const ParallelBody& body, std::initializer_list<ParallelReduction> reductions)
+{
+	Variable::List* l;
+	if (!Variable::listCheck(list, l))
+	{
+		runtimeException("'parallel for each' loop can only iterate over a list; got type " + list.typeString());
+	}
+
+	// iterate over the elements the list has when the loop begins, as the loop body may modify the list
+	const Variable::List elements = *l;
+	if (elements.empty())
+	{
+		return;
+	}
+
+	ThreadPool& pool = ThreadPool::instance();
+	size_t numTasks = std::min(elements.size(), pool.size() * TASKS_PER_THREAD);
+	std::vector<ParallelReductions> accumulators(numTasks, ParallelReductions(reductions.size()));
+	std::vector<std::shared_ptr<Task>> ranges;
+
+	// a range is only run once it is claimed by tryRun, and every range is claimed before the loop returns,
+	// so the range tasks may refer to the loop's locals even though the pool may hold them for longer
+	for (size_t i = 0; i < numTasks; i++)
+	{
+		std::shared_ptr<Task> range = std::make_shared<Task>([&, i]() {
+			size_t begin = elements.size() * i / numTasks;
+			size_t end = elements.size() * (i + 1) / numTasks;
+			for (size_t j = begin; j < end; j++)
+			{
+				body(accumulators[i], elements[j]);
+			}
+			return Variable();
+		});
+		ranges.push_back(range);
+		pool.submit([range]() { range->tryRun(); });
+	}
+	for (size_t i = numTasks; i > 0; i--)
+	{
+		ranges[i - 1]->tryRun();
+	}
+	for (const std::shared_ptr<Task>& range : ranges)
+	{
+		range->await();
+	}
+
+	size_t index = 0;
+	for (const ParallelReduction& e : reductions)
+	{
+		for (const ParallelReductions& acc : accumulators)
+		{
+			acc.applyTo(e, index);
+		}
+		index++;
+	}
+}
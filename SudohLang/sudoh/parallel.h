@@ -0,0 +1,48 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "variable.h"
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+
+// a variable declared outside of a 'parallel for each' loop which is updated by a reduction
+// e.g. 'total <- total + e' inside of the loop, and the operator ('+', '-', or '*') used
+struct ParallelReduction
+{
+	Variable& target;
+	const char op;
+};
+
+// per-task accumulators of the reductions made in a 'parallel for each' loop. Each task accumulates
+// its reductions separately; the accumulators of all tasks are applied to the reduction variables in
+// the order of the elements iterated over once the loop has finished
+class ParallelReductions
+{
+	std::vector<Variable> values;
+	std::vector<bool> used;
+
+public:
+	ParallelReductions(size_t numReductions);
+	void add(size_t reduction, char op, const Variable& value);
+	void applyTo(const ParallelReduction& reduction, size_t index) const;
+};
+
+// held while assigning to an element of a list or object declared outside of a 'parallel for each'
+// loop, so that only one such assignment is made at a time
+class ParallelStore
+{
+	std::lock_guard<std::mutex> lock;
+
+	static std::mutex& storeLock();
+
+public:
+	ParallelStore();
+};
+
+typedef std::function<void(ParallelReductions&, Variable)> ParallelBody;
+
+void parallelForEach(const Variable& list, const ParallelBody& body,
+	std::initializer_list<ParallelReduction> reductions = {});
+
+#endif
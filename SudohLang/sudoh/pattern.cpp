@@ -0,0 +1,606 @@
+#include "pattern.h"
+#include "runtime_ex.h"
+#include <cstring>
+#include <cctype>
+#include <list>
+#include <unordered_map>
+
+// groups nested more deeply than this are not parsed, so that parsing cannot overflow the stack
+constexpr size_t MAX_PATTERN_DEPTH = 1000;
+// limits on counted repetitions and the size of compiled programs, which grow with the counts
+constexpr int MAX_REPEAT = 1000;
+constexpr size_t MAX_PROGRAM_SIZE = 100000;
+// number of compiled patterns kept by each thread
+constexpr size_t PATTERN_CACHE_SIZE = 64;
+
+// +-----------------------+
+// |   Parsing patterns    |
+// +-----------------------+
+
+struct Pattern::Node
+{
+	enum class Kind { empty, character, any, charClass, textBegin, textEnd, concat, alternate, repeat };
+
+	Kind kind;
+	uint8_t c = 0;
+	uint32_t cls = 0;
+	// bounds of a repetition; 'max' is -1 if there is no upper bound
+	int min = 0, max = 0;
+	bool greedy = true;
+	std::vector<Node> children;
+
+	explicit Node(Kind kind) : kind(kind) {}
+};
+
+// parses a pattern into a tree of nodes by recursive descent; character classes are added to 'classes'
+class Pattern::Parser
+{
+	const std::string& source;
+	const char* pos;
+	const char* end;
+	std::vector<std::bitset<256>>& classes;
+	size_t depth;
+
+	void error(const std::string& message)
+	{
+		runtimeException("invalid pattern '" + source + "': " + message);
+	}
+
+	Node classNode(const std::bitset<256>& set)
+	{
+		Node node(Node::Kind::charClass);
+		node.cls = (uint32_t)classes.size();
+		classes.push_back(set);
+		return node;
+	}
+
+	// sets 'set' to the characters of an escape such as '\d', returning false if the escape is not a class
+	static bool escapeClass(char e, std::bitset<256>& set)
+	{
+		set.reset();
+		switch (e)
+		{
+		case 'd':
+		case 'D':
+			for (int c = '0'; c <= '9'; c++)
+			{
+				set[c] = true;
+			}
+			break;
+		case 'w':
+		case 'W':
+			for (int c = 0; c < 256; c++)
+			{
+				set[c] = isalnum(c) || c == '_';
+			}
+			break;
+		case 's':
+		case 'S':
+			for (char c : { ' ', '\t', '\n', '\r', '\v', '\f' })
+			{
+				set[(uint8_t)c] = true;
+			}
+			break;
+		default:
+			return false;
+		}
+		if (isupper((unsigned char)e))
+		{
+			set.flip();
+		}
+		return true;
+	}
+
+	static uint8_t escapedChar(char e)
+	{
+		switch (e)
+		{
+		case 'n':
+			return '\n';
+		case 't':
+			return '\t';
+		case 'r':
+			return '\r';
+		default:
+			return (uint8_t)e;
+		}
+	}
+
+	char escape()
+	{
+		if (pos == end)
+		{
+			error("ends with '\\'");
+		}
+		return *pos++;
+	}
+
+	int count()
+	{
+		if (pos == end || !isdigit((unsigned char)*pos))
+		{
+			error("expected a number in '{}'");
+		}
+		int n = 0;
+		while (pos != end && isdigit((unsigned char)*pos))
+		{
+			n = n * 10 + (*pos++ - '0');
+			if (n > MAX_REPEAT)
+			{
+				error("repetition of more than " + std::to_string(MAX_REPEAT));
+			}
+		}
+		return n;
+	}
+
+	Node charClass()
+	{
+		std::bitset<256> set, escaped;
+		bool negate = pos != end && *pos == '^';
+		if (negate)
+		{
+			pos++;
+		}
+		// a ']' first in a class is a character of it
+		for (bool first = true; ; first = false)
+		{
+			if (pos == end)
+			{
+				error("missing ']'");
+			}
+			char c = *pos++;
+			if (c == ']' && !first)
+			{
+				break;
+			}
+			uint8_t low = (uint8_t)c;
+			if (c == '\\')
+			{
+				char e = escape();
+				if (escapeClass(e, escaped))
+				{
+					set |= escaped;
+					continue;
+				}
+				low = escapedChar(e);
+			}
+			uint8_t high = low;
+			if (end - pos >= 2 && *pos == '-' && pos[1] != ']')
+			{
+				pos++;
+				c = *pos++;
+				high = c == '\\' ? escapedChar(escape()) : (uint8_t)c;
+				if (high < low)
+				{
+					error("invalid range in '[]'");
+				}
+			}
+			for (int i = low; i <= high; i++)
+			{
+				set[i] = true;
+			}
+		}
+		if (negate)
+		{
+			set.flip();
+		}
+		return classNode(set);
+	}
+
+	Node atom()
+	{
+		char c = *pos++;
+		switch (c)
+		{
+		case '(':
+		{
+			if (end - pos >= 2 && pos[0] == '?' && pos[1] == ':')
+			{
+				pos += 2;
+			}
+			if (++depth > MAX_PATTERN_DEPTH)
+			{
+				error("groups nested too deeply");
+			}
+			Node inner = alternation();
+			if (pos == end || *pos != ')')
+			{
+				error("missing ')'");
+			}
+			pos++;
+			depth--;
+			return inner;
+		}
+		case '[':
+			return charClass();
+		case '.':
+			return Node(Node::Kind::any);
+		case '^':
+			return Node(Node::Kind::textBegin);
+		case '$':
+			return Node(Node::Kind::textEnd);
+		case '*':
+		case '+':
+		case '?':
+		case '{':
+			error(std::string("nothing to repeat before '") + c + "'");
+			break;
+		case '\\':
+		{
+			char e = escape();
+			std::bitset<256> set;
+			if (escapeClass(e, set))
+			{
+				return classNode(set);
+			}
+			c = (char)escapedChar(e);
+			break;
+		}
+		}
+		Node node(Node::Kind::character);
+		node.c = (uint8_t)c;
+		return node;
+	}
+
+	Node repetition()
+	{
+		Node node = atom();
+		while (pos != end)
+		{
+			int min, max;
+			if (*pos == '*')
+			{
+				min = 0, max = -1;
+			}
+			else if (*pos == '+')
+			{
+				min = 1, max = -1;
+			}
+			else if (*pos == '?')
+			{
+				min = 0, max = 1;
+			}
+			else if (*pos == '{')
+			{
+				pos++;
+				min = max = count();
+				if (pos != end && *pos == ',')
+				{
+					pos++;
+					max = pos != end && *pos == '}' ? -1 : count();
+				}
+				if (pos == end || *pos != '}')
+				{
+					error("missing '}'");
+				}
+				if (max != -1 && max < min)
+				{
+					error("invalid bounds in '{}'");
+				}
+			}
+			else
+			{
+				break;
+			}
+			pos++;
+
+			Node repeat(Node::Kind::repeat);
+			repeat.min = min;
+			repeat.max = max;
+			if (pos != end && *pos == '?')
+			{
+				repeat.greedy = false;
+				pos++;
+			}
+			repeat.children.push_back(std::move(node));
+			node = std::move(repeat);
+		}
+		return node;
+	}
+
+	Node concatenation()
+	{
+		Node node(Node::Kind::concat);
+		while (pos != end && *pos != '|' && *pos != ')')
+		{
+			node.children.push_back(repetition());
+		}
+		if (node.children.size() == 1)
+		{
+			return std::move(node.children[0]);
+		}
+		return node.children.empty() ? Node(Node::Kind::empty) : node;
+	}
+
+	Node alternation()
+	{
+		Node first = concatenation();
+		if (pos == end || *pos != '|')
+		{
+			return first;
+		}
+		Node node(Node::Kind::alternate);
+		node.children.push_back(std::move(first));
+		while (pos != end && *pos == '|')
+		{
+			pos++;
+			node.children.push_back(concatenation());
+		}
+		return node;
+	}
+
+public:
+	Parser(const std::string& source, std::vector<std::bitset<256>>& classes) :
+		source(source), pos(source.data()), end(source.data() + source.length()), classes(classes), depth(0) {}
+
+	Node parse()
+	{
+		Node root = alternation();
+		if (pos != end)
+		{
+			error("unmatched ')'");
+		}
+		return root;
+	}
+};
+
+// +-------------------------+
+// |   Compiling patterns    |
+// +-------------------------+
+
+uint32_t Pattern::append(Op op, uint8_t c, uint32_t x, uint32_t y)
+{
+	if (program.size() >= MAX_PROGRAM_SIZE)
+	{
+		runtimeException("invalid pattern '" + source + "': pattern is too large");
+	}
+	program.push_back({ op, c, x, y });
+	return (uint32_t)program.size() - 1;
+}
+
+void Pattern::emit(const Node& node)
+{
+	switch (node.kind)
+	{
+	case Node::Kind::empty:
+		break;
+	case Node::Kind::character:
+		append(Op::character, node.c);
+		break;
+	case Node::Kind::any:
+		append(Op::any);
+		break;
+	case Node::Kind::charClass:
+		append(Op::charClass, 0, node.cls);
+		break;
+	case Node::Kind::textBegin:
+		append(Op::textBegin);
+		break;
+	case Node::Kind::textEnd:
+		append(Op::textEnd);
+		break;
+	case Node::Kind::concat:
+		for (const Node& child : node.children)
+		{
+			emit(child);
+		}
+		break;
+	case Node::Kind::alternate:
+	{
+		// each alternative but the last is preceded by a split to it or the next, and followed by a jump to the end
+		std::vector<uint32_t> jumps;
+		for (size_t i = 0; i < node.children.size(); i++)
+		{
+			if (i + 1 == node.children.size())
+			{
+				emit(node.children[i]);
+				break;
+			}
+			uint32_t split = append(Op::split);
+			program[split].x = (uint32_t)program.size();
+			emit(node.children[i]);
+			jumps.push_back(append(Op::jump));
+			program[split].y = (uint32_t)program.size();
+		}
+		for (uint32_t jump : jumps)
+		{
+			program[jump].x = (uint32_t)program.size();
+		}
+		break;
+	}
+	case Node::Kind::repeat:
+	{
+		const Node& child = node.children[0];
+		for (int i = 0; i < node.min; i++)
+		{
+			emit(child);
+		}
+		// a split either into the repeated node or past it; preferring the node is greedy
+		auto loop = [&](uint32_t split, uint32_t after)
+		{
+			program[split].x = node.greedy ? split + 1 : after;
+			program[split].y = node.greedy ? after : split + 1;
+		};
+		if (node.max == -1)
+		{
+			uint32_t split = append(Op::split);
+			emit(child);
+			append(Op::jump, 0, split);
+			loop(split, (uint32_t)program.size());
+		}
+		else
+		{
+			for (int i = node.min; i < node.max; i++)
+			{
+				uint32_t split = append(Op::split);
+				emit(child);
+				loop(split, (uint32_t)program.size());
+			}
+		}
+		break;
+	}
+	}
+}
+
+Pattern::Pattern(const std::string& source) : source(source), firstChar(-1)
+{
+	Parser parser(source, classes);
+	emit(parser.parse());
+	append(Op::match);
+	if (program[0].op == Op::character)
+	{
+		firstChar = program[0].c;
+	}
+}
+
+// +-----------------------+
+// |   Running patterns    |
+// +-----------------------+
+
+void Pattern::ThreadList::reset(size_t programSize)
+{
+	threads.clear();
+	if (marks.size() != programSize || ++generation == 0)
+	{
+		marks.assign(programSize, 0);
+		generation = 1;
+	}
+}
+
+bool Pattern::accepts(const Instruction& inst, uint8_t c) const
+{
+	switch (inst.op)
+	{
+	case Op::character:
+		return c == inst.c;
+	case Op::any:
+		return c != '\n';
+	case Op::charClass:
+		return classes[inst.x][c];
+	default:
+		return false;
+	}
+}
+
+// adds a thread at an instruction to a list, following splits, jumps and assertions (in order of preference,
+// without recursion) to the instructions which read a character or match
+void Pattern::addThread(ThreadList& list, uint32_t pc, const char* start, const char* pos, const char* begin,
+	const char* end)
+{
+	stack.push_back(pc);
+	while (!stack.empty())
+	{
+		pc = stack.back();
+		stack.pop_back();
+		if (list.marks[pc] == list.generation)
+		{
+			continue;
+		}
+		list.marks[pc] = list.generation;
+
+		const Instruction& inst = program[pc];
+		switch (inst.op)
+		{
+		case Op::jump:
+			stack.push_back(inst.x);
+			break;
+		case Op::split:
+			stack.push_back(inst.y);
+			stack.push_back(inst.x);
+			break;
+		case Op::textBegin:
+			if (pos == begin)
+			{
+				stack.push_back(pc + 1);
+			}
+			break;
+		case Op::textEnd:
+			if (pos == end)
+			{
+				stack.push_back(pc + 1);
+			}
+			break;
+		default:
+			list.threads.push_back({ pc, start });
+		}
+	}
+}
+
+bool Pattern::search(const char* begin, const char* end, const char* from, const char*& matchBegin,
+	const char*& matchEnd)
+{
+	current.reset(program.size());
+	bool matched = false;
+	for (const char* pos = from; ; pos++)
+	{
+		// a new thread starts at each position until a match is found, after those which started earlier
+		if (!matched)
+		{
+			if (current.threads.empty() && firstChar != -1)
+			{
+				pos = (const char*)memchr(pos, firstChar, end - pos);
+				if (!pos)
+				{
+					break;
+				}
+			}
+			addThread(current, 0, pos, pos, begin, end);
+		}
+		if (current.threads.empty())
+		{
+			break;
+		}
+
+		next.reset(program.size());
+		for (const Thread& thread : current.threads)
+		{
+			const Instruction& inst = program[thread.pc];
+			if (inst.op == Op::match)
+			{
+				// threads after this one are less preferred, so are dropped
+				matched = true;
+				matchBegin = thread.start;
+				matchEnd = pos;
+				break;
+			}
+			if (pos != end && accepts(inst, (uint8_t)*pos))
+			{
+				addThread(next, thread.pc + 1, thread.start, pos + 1, begin, end);
+			}
+		}
+		std::swap(current, next);
+		if (pos == end)
+		{
+			break;
+		}
+	}
+	return matched;
+}
+
+// +-------------------+
+// |   Pattern cache   |
+// +-------------------+
+
+// patterns used by this thread, most recently used first. Each thread has its own cache, so that a pattern
+// (and the lists it searches with) is only ever used by one thread
+thread_local std::list<std::shared_ptr<Pattern>> recentPatterns;
+thread_local std::unordered_map<std::string, std::list<std::shared_ptr<Pattern>>::iterator> patternIndex;
+
+std::shared_ptr<Pattern> Pattern::compiled(const std::string& source)
+{
+	auto found = patternIndex.find(source);
+	if (found != patternIndex.end())
+	{
+		recentPatterns.splice(recentPatterns.begin(), recentPatterns, found->second);
+		return *found->second;
+	}
+
+	recentPatterns.push_front(std::make_shared<Pattern>(source));
+	patternIndex.emplace(source, recentPatterns.begin());
+	if (recentPatterns.size() > PATTERN_CACHE_SIZE)
+	{
+		patternIndex.erase(recentPatterns.back()->source);
+		recentPatterns.pop_back();
+	}
+	return recentPatterns.front();
+}
@@ -0,0 +1,76 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <string>
+#include <vector>
+#include <bitset>
+#include <memory>
+#include <cstdint>
+
+// a pattern compiled into a program for a Pike VM, which runs every possible path through the pattern at
+// once, one character of the text at a time, so that searching takes time linear in the length of the
+// text (unlike backtracking engines such as std::regex). Patterns support literal characters, '.', classes
+// ('[a-z]', '[^,]'), the escapes '\d', '\w' and '\s' (and their negations), groups, '|', the quantifiers
+// '*', '+', '?' and '{n,m}' (followed by '?' to match as few characters as possible), and '^' and '$',
+// which match the beginning and end of the text. Matches are leftmost, and prefer earlier alternatives
+class Pattern
+{
+	enum class Op : uint8_t { character, any, charClass, split, jump, textBegin, textEnd, match };
+
+	struct Instruction
+	{
+		Op op;
+		uint8_t c;
+		// the class of a 'charClass', or the targets of a 'split' (preferring 'x') or a 'jump'
+		uint32_t x, y;
+	};
+
+	struct Thread
+	{
+		uint32_t pc;
+		const char* start;
+	};
+
+	// threads at one position in the text, in order of preference, with each instruction on the list at most once
+	struct ThreadList
+	{
+		std::vector<Thread> threads;
+		std::vector<uint32_t> marks;
+		uint32_t generation = 0;
+
+		void reset(size_t programSize);
+	};
+
+	struct Node;
+	class Parser;
+
+	std::string source;
+	std::vector<Instruction> program;
+	std::vector<std::bitset<256>> classes;
+	// a character that every match begins with, if there is one; text before it is skipped with memchr
+	int firstChar;
+
+	// lists used while searching, kept between searches to avoid allocating
+	ThreadList current, next;
+	std::vector<uint32_t> stack;
+
+	void emit(const Node& node);
+	uint32_t append(Op op, uint8_t c = 0, uint32_t x = 0, uint32_t y = 0);
+	bool accepts(const Instruction& inst, uint8_t c) const;
+	void addThread(ThreadList& list, uint32_t pc, const char* start, const char* pos, const char* begin,
+		const char* end);
+
+public:
+	explicit Pattern(const std::string& source);
+	Pattern(const Pattern&) = delete;
+	Pattern& operator=(const Pattern&) = delete;
+
+	// finds the first match in [begin, end) beginning at or after 'from', setting 'matchBegin' and 'matchEnd'
+	bool search(const char* begin, const char* end, const char* from, const char*& matchBegin,
+		const char*& matchEnd);
+
+	// returns a compiled pattern from a cache of those most recently used by this thread
+	static std::shared_ptr<Pattern> compiled(const std::string& source);
+};
+
+#endif
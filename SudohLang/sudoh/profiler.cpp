@@ -0,0 +1,121 @@
+#include "profiler.h"
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+#include <mutex>
+
+// the profile scope of the innermost procedure call currently being run
+static thread_local ProfileScope* currentScope = nullptr;
+// the number of calls of each procedure currently being run by this thread, by the procedures' indices
+static thread_local std::vector<int> depths;
+
+static const ProfileClock::time_point programBegin = ProfileClock::now();
+
+static std::vector<std::unique_ptr<ProfiledProcedure>>& profiledProcedures()
+{
+	static std::vector<std::unique_ptr<ProfiledProcedure>> procedures;
+	return procedures;
+}
+
+ProfileScope::ProfileScope(ProfiledProcedure* procedure) : proc(procedure), caller(currentScope),
+	begin(ProfileClock::now()), calleeTime(ProfileClock::duration::zero())
+{
+	proc->calls++;
+	if (depths.size() <= proc->index)
+	{
+		depths.resize(proc->index + 1);
+	}
+	int depth = ++depths[proc->index];
+	int maxDepth = proc->maxDepth.load();
+	while (depth > maxDepth && !proc->maxDepth.compare_exchange_weak(maxDepth, depth));
+	currentScope = this;
+}
+
+ProfileScope::~ProfileScope()
+{
+	ProfileClock::duration elapsed = ProfileClock::now() - begin;
+
+	// only count time of outermost call of a recursive procedure so that it is not counted multiple times
+	if (--depths[proc->index] == 0)
+	{
+		proc->inclusive += elapsed.count();
+	}
+	proc->exclusive += (elapsed - calleeTime).count();
+
+	if (caller)
+	{
+		caller->calleeTime += elapsed;
+	}
+	currentScope = caller;
+}
+
+static double toMillis(ProfileClock::rep ticks)
+{
+	return std::chrono::duration<double, std::milli>(ProfileClock::duration(ticks)).count();
+}
+
+// writes the profile of all procedures to the file specified by SUDOH_PROFILE_OUTPUT, either in JSON
+// format or as a human-readable table depending on SUDOH_PROFILE_FORMAT
+static void writeProfile()
+{
+	const char* format = getenv("SUDOH_PROFILE_FORMAT");
+	bool json = format && std::string(format) == "json";
+	const char* output = getenv("SUDOH_PROFILE_OUTPUT");
+	std::string fileName = output ? output : (json ? "sudoh_profile.json" : "sudoh_profile.txt");
+
+	// most expensive procedures first
+	std::vector<ProfiledProcedure*> procs;
+	for (auto& e : profiledProcedures())
+	{
+		procs.push_back(e.get());
+	}
+	std::sort(procs.begin(), procs.end(), [](ProfiledProcedure* a, ProfiledProcedure* b) {
+		return a->exclusive > b->exclusive;
+	});
+
+	std::ofstream out(fileName);
+	out << std::fixed << std::setprecision(3);
+	double total = toMillis((ProfileClock::now() - programBegin).count());
+
+	if (json)
+	{
+		out << "{\n  \"totalMs\": " << total << ",\n  \"procedures\": [";
+		for (size_t i = 0; i < procs.size(); i++)
+		{
+			ProfiledProcedure* p = procs[i];
+			out << (i == 0 ? "\n" : ",\n") << "    { \"name\": \"" << p->name << "\", \"params\": " << p->numParams <<
+				", \"calls\": " << p->calls << ", \"inclusiveMs\": " << toMillis(p->inclusive) <<
+				", \"exclusiveMs\": " << toMillis(p->exclusive) << ", \"maxDepth\": " << p->maxDepth << " }";
+		}
+		out << "\n  ]\n}\n";
+		return;
+	}
+
+	out << "Sudoh procedure profile; total run time " << total << " ms\n\n" << std::left <<
+		std::setw(32) << "procedure" << std::setw(14) << "calls" << std::setw(18) << "inclusive (ms)" <<
+		std::setw(18) << "exclusive (ms)" << "max depth\n";
+	for (ProfiledProcedure* p : procs)
+	{
+		out << std::setw(32) << p->name + "/" + std::to_string(p->numParams) << std::setw(14) << p->calls <<
+			std::setw(18) << toMillis(p->inclusive) << std::setw(18) << toMillis(p->exclusive) << p->maxDepth << "\n";
+	}
+}
+
+// registers a procedure to be profiled; the profile is written once the program exits
+ProfiledProcedure* profileProcedure(const std::string name, int numParams)
+{
+	static std::mutex registerLock;
+	std::lock_guard<std::mutex> lock(registerLock);
+
+	std::vector<std::unique_ptr<ProfiledProcedure>>& procedures = profiledProcedures();
+	if (procedures.empty())
+	{
+		atexit(writeProfile);
+	}
+
+	procedures.emplace_back(new ProfiledProcedure{ name, numParams, procedures.size(), { 0 }, { 0 }, { 0 }, { 0 } });
+	return procedures.back().get();
+}
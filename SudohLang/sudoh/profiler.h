@@ -0,0 +1,44 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <string>
+#include <chrono>
+#include <atomic>
+
+typedef std::chrono::steady_clock ProfileClock;
+
+// profiling statistics of a single Sudoh procedure; updated atomically as the procedure may be
+// called by multiple threads in parallel loops
+struct ProfiledProcedure
+{
+	const std::string name;
+	const int numParams;
+	// order in which the procedure was registered, which its recursion depth on each thread is kept by
+	const size_t index;
+
+	std::atomic<unsigned long long> calls;
+	// time spent in the procedure including/excluding time spent in procedures called from it, in clock ticks
+	std::atomic<ProfileClock::rep> inclusive;
+	std::atomic<ProfileClock::rep> exclusive;
+	// maximum number of calls of the procedure on the same thread at once (recursion depth); calls made at
+	// the same time by different threads are not recursion, so the current depth is kept for each thread
+	std::atomic<int> maxDepth;
+};
+
+// records a call of a procedure; constructed at the beginning of a profiled procedure's body,
+// and records the time spent in the procedure once destroyed when the procedure returns
+class ProfileScope
+{
+	ProfiledProcedure* const proc;
+	ProfileScope* const caller;
+	const ProfileClock::time_point begin;
+	ProfileClock::duration calleeTime;
+
+public:
+	ProfileScope(ProfiledProcedure* procedure);
+	~ProfileScope();
+};
+
+ProfiledProcedure* profileProcedure(const std::string name, int numParams);
+
+#endif
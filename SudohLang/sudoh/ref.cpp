@@ -0,0 +1,169 @@
+#include "ref.h"
+#include <vector>
+#include <mutex>
+
+constexpr long long MERGED = 1;
+constexpr long long QUEUED = 2;
+constexpr long long COUNT_ONE = 4;
+
+// record of a thread which owns reference counted values, holding the values queued for it to merge
+struct RefThread
+{
+	std::mutex lock;
+	std::vector<RefCount*> queue;
+	std::atomic<bool> pending;
+	bool exited;
+
+	RefThread() : pending(false), exited(false) {}
+};
+
+// owner of all values whose counts have been merged; no thread has this record, so all threads
+// use the shared count of such values
+static RefThread mergedOwner;
+
+// merges the values queued for the current thread once it exits; values queued afterwards are merged
+// by the thread queueing them, as the owner no longer uses their biased counts
+struct RefThreadExit
+{
+	~RefThreadExit()
+	{
+		std::vector<RefCount*> queue;
+		{
+			std::lock_guard<std::mutex> lock(currentRefThread->lock);
+			currentRefThread->exited = true;
+			queue.swap(currentRefThread->queue);
+		}
+		for (RefCount* e : queue)
+		{
+			e->mergeBiased();
+		}
+	}
+};
+
+static thread_local RefThreadExit refThreadExit;
+
+// records are never freed, as values owned by a thread may outlive it
+static RefThread* ownRefThread()
+{
+	if (!currentRefThread)
+	{
+		currentRefThread = new RefThread();
+		// constructs the thread local object, registering its destructor to be run at thread exit
+		(void)&refThreadExit;
+	}
+	return currentRefThread;
+}
+
+RefCount::RefCount() : owner(ownRefThread()), biased(1), shared(0)
+{
+	mergeQueuedRefs();
+}
+
+// the owner released its last reference; all remaining references are counted in the shared count
+void RefCount::releaseBiased()
+{
+	// with no shared references (and none released by other threads), no other thread can refer to the value
+	if (shared.load(std::memory_order_acquire) == 0)
+	{
+		delete this;
+		return;
+	}
+	owner.store(&mergedOwner, std::memory_order_relaxed);
+	long long old = shared.load();
+	while (!shared.compare_exchange_weak(old, old | MERGED, std::memory_order_acq_rel));
+
+	// a queued value is freed when its owner merges the queue instead
+	if (old >> 2 == 0 && !(old & QUEUED))
+	{
+		delete this;
+	}
+}
+
+void RefCount::releaseShared()
+{
+	long long old = shared.load();
+	long long updated;
+	bool queue;
+	do
+	{
+		updated = old - COUNT_ONE;
+		queue = updated >> 2 < 0 && !(old & (QUEUED | MERGED));
+		if (queue)
+		{
+			updated |= QUEUED;
+		}
+	} while (!shared.compare_exchange_weak(old, updated, std::memory_order_acq_rel));
+
+	if (queue)
+	{
+		RefThread* o = owner.load(std::memory_order_relaxed);
+		std::unique_lock<std::mutex> lock(o->lock);
+		if (o->exited)
+		{
+			lock.unlock();
+			mergeBiased();
+			return;
+		}
+		o->queue.push_back(this);
+		o->pending.store(true);
+	}
+	else if (updated >> 2 == 0 && (updated & MERGED) && !(updated & QUEUED))
+	{
+		delete this;
+	}
+}
+
+// whether the value has a single reference, held by the current thread. No other thread can take a new
+// reference to the value while this is so, so the answer cannot become wrong until this thread copies
+// the reference. May answer false for a single reference while counts are waiting to be merged
+bool RefCount::unique() const
+{
+	RefThread* o = owner.load(std::memory_order_relaxed);
+	if (o == currentRefThread)
+	{
+		return biased == 1 && shared.load(std::memory_order_acquire) >> 2 == 0;
+	}
+	return o == &mergedOwner && shared.load(std::memory_order_acquire) >> 2 == 1;
+}
+
+// adds the biased count to the shared count; called by the owner (or for an exited owner) for a queued value
+void RefCount::mergeBiased()
+{
+	long long count = (long long)biased * COUNT_ONE;
+	biased = 0;
+	owner.store(&mergedOwner, std::memory_order_relaxed);
+
+	long long old = shared.load();
+	long long updated;
+	do
+	{
+		updated = ((old + count) | MERGED) & ~QUEUED;
+	} while (!shared.compare_exchange_weak(old, updated, std::memory_order_acq_rel));
+
+	if (updated >> 2 == 0)
+	{
+		delete this;
+	}
+}
+
+// merges the counts of values queued for the current thread; called at points where threads synchronize
+// (e.g. at the end of a parallel loop) and whenever the thread creates a new value
+void mergeQueuedRefs()
+{
+	RefThread* t = currentRefThread;
+	if (!t || !t->pending.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	std::vector<RefCount*> queue;
+	{
+		std::lock_guard<std::mutex> lock(t->lock);
+		queue.swap(t->queue);
+		t->pending.store(false);
+	}
+	for (RefCount* e : queue)
+	{
+		e->mergeBiased();
+	}
+}
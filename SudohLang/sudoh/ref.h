@@ -0,0 +1,127 @@
+#ifndef REF_H
+#define REF_H
+
+#include <atomic>
+#include <utility>
+#include <cstddef>
+
+struct RefThread;
+
+// the record of the current thread, created when the thread first creates a reference counted value
+inline thread_local RefThread* currentRefThread = nullptr;
+
+// reference count of a value shared by reference between Variables, using biased reference counting.
+// The thread which creates the value (its owner) counts its references with a non-atomic 'biased'
+// count; other threads use an atomic 'shared' count, which holds the count shifted left by 2 along
+// with the MERGED and QUEUED flags. The counts are merged once the owner has no references left, or
+// once the shared count goes negative (another thread released a reference counted by the owner),
+// in which case the value is queued for its owner to merge the next time it reaches a merge point
+class RefCount
+{
+	std::atomic<RefThread*> owner;
+	size_t biased;
+	std::atomic<long long> shared;
+
+	void releaseBiased();
+	void releaseShared();
+
+public:
+	RefCount();
+	virtual ~RefCount() {}
+
+	void mergeBiased();
+	bool unique() const;
+
+	void retain()
+	{
+		if (owner.load(std::memory_order_relaxed) == currentRefThread)
+		{
+			biased++;
+		}
+		else
+		{
+			shared.fetch_add(4, std::memory_order_relaxed);
+		}
+	}
+
+	void release()
+	{
+		if (owner.load(std::memory_order_relaxed) == currentRefThread)
+		{
+			if (--biased == 0)
+			{
+				releaseBiased();
+			}
+		}
+		else
+		{
+			releaseShared();
+		}
+	}
+
+};
+
+void mergeQueuedRefs();
+
+// reference to a value of type T, which is freed once no references to it remain
+template <typename T>
+class Ref
+{
+	struct Box : RefCount
+	{
+		T value;
+
+		template <typename... Args>
+		Box(Args&&... args) : value(std::forward<Args>(args)...) {}
+	};
+
+	Box* box;
+
+	explicit Ref(Box* box) : box(box) {}
+
+public:
+	Ref() : box(nullptr) {}
+	explicit Ref(T value) : box(new Box(std::move(value))) {}
+
+	// returns a reference to a new value constructed in place, for values which cannot be moved
+	template <typename... Args>
+	static Ref make(Args&&... args)
+	{
+		return Ref(new Box(std::forward<Args>(args)...));
+	}
+
+	Ref(const Ref& other) : box(other.box)
+	{
+		if (box)
+		{
+			box->retain();
+		}
+	}
+	Ref(Ref&& other) noexcept : box(other.box)
+	{
+		other.box = nullptr;
+	}
+	~Ref()
+	{
+		if (box)
+		{
+			box->release();
+		}
+	}
+
+	Ref& operator=(Ref other) noexcept
+	{
+		std::swap(box, other.box);
+		return *this;
+	}
+
+	T* get() const { return box ? &box->value : nullptr; }
+	T& operator*() const { return box->value; }
+	T* operator->() const { return &box->value; }
+	// whether this is the only reference to the value, so that it may be modified without being copied
+	bool unique() const { return box->unique(); }
+	bool operator==(const Ref& other) const { return box == other.box; }
+	bool operator!=(const Ref& other) const { return box != other.box; }
+};
+
+#endif
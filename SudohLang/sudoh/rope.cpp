@@ -0,0 +1,102 @@
+#include "rope.h"
+#include <vector>
+#include <mutex>
+
+// held while flattening a rope, as ropes may be shared by threads which flatten them at the same time
+static std::mutex flattenLock;
+
+Rope::Rope(std::string text) : text(std::move(text)), size(this->text.length()), flat(true) {}
+
+Rope::Rope(Ref<Rope> left, Ref<Rope> right) :
+	left(std::move(left)), right(std::move(right)), size(this->left->size + this->right->size), flat(false) {}
+
+// a long chain of concatenations is freed one rope at a time rather than recursively, which could
+// overflow the stack
+Rope::~Rope()
+{
+	if (!left.get())
+	{
+		return;
+	}
+	std::vector<Ref<Rope>> parts;
+	parts.push_back(std::move(left));
+	parts.push_back(std::move(right));
+	while (!parts.empty())
+	{
+		Ref<Rope> part = std::move(parts.back());
+		parts.pop_back();
+		if (part.get() && part.unique())
+		{
+			parts.push_back(std::move(part->left));
+			parts.push_back(std::move(part->right));
+		}
+	}
+}
+
+// copies the characters of the parts of a concatenation into its text, in order, without recursion
+void Rope::flatten() const
+{
+	std::lock_guard<std::mutex> guard(flattenLock);
+	if (isFlat())
+	{
+		return;
+	}
+
+	std::string out;
+	out.reserve(size);
+	std::vector<const Rope*> parts = { this };
+	while (!parts.empty())
+	{
+		const Rope* part = parts.back();
+		parts.pop_back();
+		if (part->isFlat())
+		{
+			out += part->text;
+		}
+		else
+		{
+			parts.push_back(part->right.get());
+			parts.push_back(part->left.get());
+		}
+	}
+
+	text = std::move(out);
+	left = Ref<Rope>();
+	right = Ref<Rope>();
+	flat.store(true, std::memory_order_release);
+}
+
+Ref<Rope> Rope::concat(const Ref<Rope>& left, const Ref<Rope>& right)
+{
+	if (right->size == 0)
+	{
+		return left;
+	}
+	if (left->size == 0)
+	{
+		return right;
+	}
+	if (left->size + right->size < MIN_ROPE_LENGTH)
+	{
+		return Ref<Rope>::make(left->str() + right->str());
+	}
+	return Ref<Rope>::make(left, right);
+}
+
+Ref<Rope> Rope::concat(const Ref<Rope>& left, std::string right)
+{
+	if (left->size + right.length() < MIN_ROPE_LENGTH)
+	{
+		return Ref<Rope>::make(left->str() + right);
+	}
+	return concat(left, Ref<Rope>::make(std::move(right)));
+}
+
+Ref<Rope> Rope::concat(std::string left, const Ref<Rope>& right)
+{
+	if (left.length() + right->size < MIN_ROPE_LENGTH)
+	{
+		return Ref<Rope>::make(left + right->str());
+	}
+	return concat(Ref<Rope>::make(std::move(left)), right);
+}
@@ -0,0 +1,57 @@
+#ifndef ROPE_H
+#define ROPE_H
+
+#include <string>
+#include <atomic>
+#include "ref.h"
+
+// concatenations shorter than this are copied into a flat rope at once, which is cheaper than keeping
+// their parts for such short strings
+constexpr size_t MIN_ROPE_LENGTH = 256;
+
+// text of a string variable, which is either flat (held in one std::string) or the concatenation of two
+// other ropes. Concatenating long strings makes a new rope referring to both rather than copying their
+// characters, and the characters are copied into one std::string (flattening the rope) only once they are
+// needed e.g. for indexing, comparison or printing, so building a string from many pieces takes linear time
+class Rope
+{
+	mutable std::string text;
+	// the parts of a concatenation, released once it is flattened
+	mutable Ref<Rope> left, right;
+	size_t size;
+	mutable std::atomic<bool> flat;
+
+	void flatten() const;
+
+public:
+	explicit Rope(std::string text);
+	Rope(Ref<Rope> left, Ref<Rope> right);
+	Rope(const Rope&) = delete;
+	Rope& operator=(const Rope&) = delete;
+	~Rope();
+
+	static Ref<Rope> concat(const Ref<Rope>& left, const Ref<Rope>& right);
+	static Ref<Rope> concat(const Ref<Rope>& left, std::string right);
+	static Ref<Rope> concat(std::string left, const Ref<Rope>& right);
+
+	size_t length() const { return size; }
+	bool isFlat() const { return flat.load(std::memory_order_acquire); }
+
+	const std::string& str() const
+	{
+		if (!isFlat())
+		{
+			flatten();
+		}
+		return text;
+	}
+
+	// appends to a flat rope, which must not be shared
+	void append(const std::string& other)
+	{
+		text += other;
+		size = text.length();
+	}
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "sampler.h"
+
+thread_local ShadowStack shadowStack;
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <string>
+#include <map>
+#include <thread>
+#include <fstream>
+#include <cstdlib>
+#include <csignal>
+#include <ctime>
+#include <sys/time.h>
+
+// Sampling profiler enabled by setting the SUDOH_SAMPLE environment variable. SIGPROF is delivered
+// SUDOH_SAMPLE_HZ times per second of CPU time, and the signal handler copies the shadow stack of the
+// interrupted thread into a ring buffer. A background thread aggregates the samples into folded
+// stacks, which are written to SUDOH_SAMPLE_OUTPUT on exit or whenever SIGUSR1 is received
+
+struct Sample
+{
+	std::atomic<bool> ready;
+	int depth;
+	const char* frames[MAX_SHADOW_DEPTH];
+};
+
+constexpr unsigned RING_SIZE = 1024;
+static Sample ring[RING_SIZE];
+static std::atomic<unsigned> writeIdx(0);
+static std::atomic<unsigned> readIdx(0);
+
+// number of samples of each unique stack, keyed by the folded stack e.g. "main;sort/3;partition/3"
+static std::map<std::string, unsigned long long> foldedStacks;
+
+static std::thread aggregator;
+static std::atomic<bool> stopAggregator(false);
+
+static void takeSample(int)
+{
+	// claim a slot in the ring buffer; the sample is dropped if the buffer is full
+	unsigned w = writeIdx.load();
+	do
+	{
+		if (w - readIdx.load() >= RING_SIZE)
+		{
+			return;
+		}
+	} while (!writeIdx.compare_exchange_weak(w, w + 1));
+
+	Sample& s = ring[w % RING_SIZE];
+	std::atomic_signal_fence(std::memory_order_acquire);
+	s.depth = shadowStack.depth < MAX_SHADOW_DEPTH ? shadowStack.depth : MAX_SHADOW_DEPTH;
+	for (int i = 0; i < s.depth; i++)
+	{
+		s.frames[i] = shadowStack.frames[i];
+	}
+	s.ready.store(true, std::memory_order_release);
+}
+
+// moves all samples in the ring buffer into foldedStacks
+static void aggregateSamples()
+{
+	unsigned r = readIdx.load();
+	while (r != writeIdx.load() && ring[r % RING_SIZE].ready.load(std::memory_order_acquire))
+	{
+		Sample& s = ring[r % RING_SIZE];
+		std::string stack = "main";
+		for (int i = 0; i < s.depth; i++)
+		{
+			stack += ";";
+			stack += s.frames[i];
+		}
+		foldedStacks[stack]++;
+
+		s.ready.store(false, std::memory_order_relaxed);
+		readIdx.store(++r);
+	}
+}
+
+static void writeSamples()
+{
+	const char* output = getenv("SUDOH_SAMPLE_OUTPUT");
+	std::ofstream out(output ? output : "sudoh_samples.folded");
+	for (auto& e : foldedStacks)
+	{
+		out << e.first << " " << e.second << "\n";
+	}
+}
+
+static void runAggregator()
+{
+	sigset_t dumpSignal;
+	sigemptyset(&dumpSignal);
+	sigaddset(&dumpSignal, SIGUSR1);
+	const timespec timeout = { 0, 50 * 1000 * 1000 };
+
+	while (!stopAggregator.load())
+	{
+		int sig = sigtimedwait(&dumpSignal, nullptr, &timeout);
+		aggregateSamples();
+		if (sig == SIGUSR1)
+		{
+			writeSamples();
+		}
+	}
+}
+
+static void stopSampler()
+{
+	itimerval stop = {};
+	setitimer(ITIMER_PROF, &stop, nullptr);
+
+	stopAggregator.store(true);
+	aggregator.join();
+	aggregateSamples();
+	writeSamples();
+}
+
+static bool startSampler()
+{
+	const char* enabled = getenv("SUDOH_SAMPLE");
+	if (!enabled || std::string(enabled) == "" || std::string(enabled) == "0")
+	{
+		return false;
+	}
+	const char* hzVar = getenv("SUDOH_SAMPLE_HZ");
+	long hz = hzVar ? strtol(hzVar, nullptr, 10) : 999;
+	if (hz <= 0 || hz > 1000000)
+	{
+		hz = 999;
+	}
+
+	// SIGUSR1 is blocked in every thread except for the aggregator, which waits for it; SIGPROF
+	// is blocked in the aggregator so that samples are only taken of threads running Sudoh code
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGUSR1);
+	sigaddset(&signals, SIGPROF);
+	pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+	aggregator = std::thread(runAggregator);
+	sigdelset(&signals, SIGUSR1);
+	pthread_sigmask(SIG_UNBLOCK, &signals, nullptr);
+
+	struct sigaction action = {};
+	action.sa_handler = takeSample;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGPROF, &action, nullptr);
+
+	long interval = 1000000 / hz;
+	itimerval timer = { { interval / 1000000, interval % 1000000 }, { interval / 1000000, interval % 1000000 } };
+	setitimer(ITIMER_PROF, &timer, nullptr);
+
+	atexit(stopSampler);
+	return true;
+}
+
+static const bool samplerStarted = startSampler();
+
+#endif
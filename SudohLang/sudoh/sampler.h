@@ -0,0 +1,40 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <atomic>
+
+// maximum number of procedure calls recorded in a shadow stack; deeper calls are not recorded
+constexpr int MAX_SHADOW_DEPTH = 128;
+
+// stack of the names of the Sudoh procedures currently being run by a thread; read by the
+// sampling profiler when a sample is taken of the thread
+struct ShadowStack
+{
+	const char* frames[MAX_SHADOW_DEPTH];
+	int depth;
+};
+
+extern thread_local ShadowStack shadowStack;
+
+// pushes a procedure onto the current thread's shadow stack for the duration of a call
+class ShadowFrame
+{
+public:
+	ShadowFrame(const char* name)
+	{
+		if (shadowStack.depth < MAX_SHADOW_DEPTH)
+		{
+			shadowStack.frames[shadowStack.depth] = name;
+		}
+		// the frame must be written before it is made visible to the sampling signal handler
+		std::atomic_signal_fence(std::memory_order_release);
+		shadowStack.depth++;
+	}
+
+	~ShadowFrame()
+	{
+		shadowStack.depth--;
+	}
+};
+
+#endif
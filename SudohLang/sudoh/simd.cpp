@@ -0,0 +1,544 @@
+#include "simd.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+// +-------------------------------+
+// |  plain kernels (any CPU)      |
+// +-------------------------------+
+
+static double plainSum(const double* data, size_t n)
+{
+	double sum = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		sum += data[i];
+	}
+	return sum;
+}
+
+static double plainMin(const double* data, size_t n)
+{
+	double min = data[0];
+	for (size_t i = 1; i < n; i++)
+	{
+		min = data[i] < min ? data[i] : min;
+	}
+	return min;
+}
+
+static double plainMax(const double* data, size_t n)
+{
+	double max = data[0];
+	for (size_t i = 1; i < n; i++)
+	{
+		max = data[i] > max ? data[i] : max;
+	}
+	return max;
+}
+
+static double plainDot(const double* a, const double* b, size_t n)
+{
+	double sum = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		sum += a[i] * b[i];
+	}
+	return sum;
+}
+
+static void plainScale(const double* data, double factor, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		out[i] = data[i] * factor;
+	}
+}
+
+static void plainAdd(const double* a, const double* b, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		out[i] = a[i] + b[i];
+	}
+}
+
+static void plainSubtract(const double* a, const double* b, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		out[i] = a[i] - b[i];
+	}
+}
+
+static void plainMultiply(const double* a, const double* b, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		out[i] = a[i] * b[i];
+	}
+}
+
+static void plainAxpy(double factor, const double* data, double* out, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		out[i] += factor * data[i];
+	}
+}
+
+static const char* plainFindEither(const char* data, const char* end, char a, char b)
+{
+	while (data < end && *data != a && *data != b)
+	{
+		data++;
+	}
+	return data;
+}
+
+#ifdef SIMD_X86
+
+// +-------------------------------+
+// |  SSE2 kernels (any x86-64)    |
+// +-------------------------------+
+
+static double sumLanes(__m128d v)
+{
+	return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static double sseSum(const double* data, size_t n)
+{
+	// two accumulators so consecutive additions do not wait on each other
+	__m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		acc0 = _mm_add_pd(acc0, _mm_loadu_pd(data + i));
+		acc1 = _mm_add_pd(acc1, _mm_loadu_pd(data + i + 2));
+	}
+	double sum = sumLanes(_mm_add_pd(acc0, acc1));
+	for (; i < n; i++)
+	{
+		sum += data[i];
+	}
+	return sum;
+}
+
+static double sseMin(const double* data, size_t n)
+{
+	if (n < 2)
+	{
+		return data[0];
+	}
+	__m128d acc = _mm_loadu_pd(data);
+	for (size_t i = 2; i + 2 <= n; i += 2)
+	{
+		acc = _mm_min_pd(_mm_loadu_pd(data + i), acc);
+	}
+	// the last (possibly overlapping) pair covers a remaining odd number
+	acc = _mm_min_pd(_mm_loadu_pd(data + n - 2), acc);
+	return _mm_cvtsd_f64(_mm_min_sd(acc, _mm_unpackhi_pd(acc, acc)));
+}
+
+static double sseMax(const double* data, size_t n)
+{
+	if (n < 2)
+	{
+		return data[0];
+	}
+	__m128d acc = _mm_loadu_pd(data);
+	for (size_t i = 2; i + 2 <= n; i += 2)
+	{
+		acc = _mm_max_pd(_mm_loadu_pd(data + i), acc);
+	}
+	// the last (possibly overlapping) pair covers a remaining odd number
+	acc = _mm_max_pd(_mm_loadu_pd(data + n - 2), acc);
+	return _mm_cvtsd_f64(_mm_max_sd(acc, _mm_unpackhi_pd(acc, acc)));
+}
+
+static double sseDot(const double* a, const double* b, size_t n)
+{
+	__m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+		acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+	}
+	double sum = sumLanes(_mm_add_pd(acc0, acc1));
+	for (; i < n; i++)
+	{
+		sum += a[i] * b[i];
+	}
+	return sum;
+}
+
+static void sseScale(const double* data, double factor, double* out, size_t n)
+{
+	__m128d f = _mm_set1_pd(factor);
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		_mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(data + i), f));
+	}
+	plainScale(data + i, factor, out + i, n - i);
+}
+
+static void sseAdd(const double* a, const double* b, double* out, size_t n)
+{
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		_mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+	}
+	plainAdd(a + i, b + i, out + i, n - i);
+}
+
+static void sseSubtract(const double* a, const double* b, double* out, size_t n)
+{
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		_mm_storeu_pd(out + i, _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+	}
+	plainSubtract(a + i, b + i, out + i, n - i);
+}
+
+static void sseMultiply(const double* a, const double* b, double* out, size_t n)
+{
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		_mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+	}
+	plainMultiply(a + i, b + i, out + i, n - i);
+}
+
+static void sseAxpy(double factor, const double* data, double* out, size_t n)
+{
+	__m128d f = _mm_set1_pd(factor);
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		_mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(out + i), _mm_mul_pd(f, _mm_loadu_pd(data + i))));
+	}
+	plainAxpy(factor, data + i, out + i, n - i);
+}
+
+// returns the index of the lowest set bit of a non-zero mask
+static unsigned lowestBit(unsigned mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+static const char* sseFindEither(const char* data, const char* end, char a, char b)
+{
+	__m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b);
+	for (; data + 16 <= end; data += 16)
+	{
+		__m128i chunk = _mm_loadu_si128((const __m128i*)data);
+		unsigned mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb)));
+		if (mask)
+		{
+			return data + lowestBit(mask);
+		}
+	}
+	return plainFindEither(data, end, a, b);
+}
+
+// +-------------------------------+
+// |  AVX2 kernels                 |
+// +-------------------------------+
+
+TARGET_AVX2 static double sumLanes(__m256d v)
+{
+	return sumLanes(_mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+}
+
+TARGET_AVX2 static double avxSum(const double* data, size_t n)
+{
+	__m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(data + i));
+		acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(data + i + 4));
+	}
+	double sum = sumLanes(_mm256_add_pd(acc0, acc1));
+	for (; i < n; i++)
+	{
+		sum += data[i];
+	}
+	return sum;
+}
+
+TARGET_AVX2 static double avxMin(const double* data, size_t n)
+{
+	if (n < 4)
+	{
+		return plainMin(data, n);
+	}
+	__m256d acc = _mm256_loadu_pd(data);
+	size_t i = 4;
+	for (; i + 4 <= n; i += 4)
+	{
+		acc = _mm256_min_pd(_mm256_loadu_pd(data + i), acc);
+	}
+	// the last (possibly overlapping) group of four covers the remaining numbers
+	acc = _mm256_min_pd(_mm256_loadu_pd(data + n - 4), acc);
+	__m128d half = _mm_min_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+	return _mm_cvtsd_f64(_mm_min_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+TARGET_AVX2 static double avxMax(const double* data, size_t n)
+{
+	if (n < 4)
+	{
+		return plainMax(data, n);
+	}
+	__m256d acc = _mm256_loadu_pd(data);
+	size_t i = 4;
+	for (; i + 4 <= n; i += 4)
+	{
+		acc = _mm256_max_pd(_mm256_loadu_pd(data + i), acc);
+	}
+	acc = _mm256_max_pd(_mm256_loadu_pd(data + n - 4), acc);
+	__m128d half = _mm_max_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+	return _mm_cvtsd_f64(_mm_max_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+TARGET_AVX2 static double avxDot(const double* a, const double* b, size_t n)
+{
+	__m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+		acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), acc1);
+	}
+	double sum = sumLanes(_mm256_add_pd(acc0, acc1));
+	for (; i < n; i++)
+	{
+		sum += a[i] * b[i];
+	}
+	return sum;
+}
+
+TARGET_AVX2 static void avxScale(const double* data, double factor, double* out, size_t n)
+{
+	__m256d f = _mm256_set1_pd(factor);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		_mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(data + i), f));
+	}
+	plainScale(data + i, factor, out + i, n - i);
+}
+
+TARGET_AVX2 static void avxAdd(const double* a, const double* b, double* out, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		_mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+	}
+	plainAdd(a + i, b + i, out + i, n - i);
+}
+
+TARGET_AVX2 static void avxSubtract(const double* a, const double* b, double* out, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		_mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+	}
+	plainSubtract(a + i, b + i, out + i, n - i);
+}
+
+TARGET_AVX2 static void avxMultiply(const double* a, const double* b, double* out, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		_mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+	}
+	plainMultiply(a + i, b + i, out + i, n - i);
+}
+
+TARGET_AVX2 static void avxAxpy(double factor, const double* data, double* out, size_t n)
+{
+	__m256d f = _mm256_set1_pd(factor);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		_mm256_storeu_pd(out + i, _mm256_fmadd_pd(f, _mm256_loadu_pd(data + i), _mm256_loadu_pd(out + i)));
+	}
+	plainAxpy(factor, data + i, out + i, n - i);
+}
+
+TARGET_AVX2 static const char* avxFindEither(const char* data, const char* end, char a, char b)
+{
+	__m256i va = _mm256_set1_epi8(a), vb = _mm256_set1_epi8(b);
+	for (; data + 32 <= end; data += 32)
+	{
+		__m256i chunk = _mm256_loadu_si256((const __m256i*)data);
+		unsigned mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, va), _mm256_cmpeq_epi8(chunk, vb)));
+		if (mask)
+		{
+			return data + lowestBit(mask);
+		}
+	}
+	return sseFindEither(data, end, a, b);
+}
+
+// whether the CPU and operating system support AVX2 and FMA instructions
+static bool hasAvx2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+	__cpuid(info, 1);
+	bool fma = info[2] & (1 << 12), osxsave = info[2] & (1 << 27);
+	if (!fma || !osxsave || (_xgetbv(0) & 6) != 6)
+	{
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return info[1] & (1 << 5);
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif
+
+// +-------------------------------+
+// |  dispatch                     |
+// +-------------------------------+
+
+struct Kernels
+{
+	double (*sum)(const double*, size_t);
+	double (*min)(const double*, size_t);
+	double (*max)(const double*, size_t);
+	double (*dot)(const double*, const double*, size_t);
+	void (*scale)(const double*, double, double*, size_t);
+	void (*add)(const double*, const double*, double*, size_t);
+	void (*subtract)(const double*, const double*, double*, size_t);
+	void (*multiply)(const double*, const double*, double*, size_t);
+	void (*axpy)(double, const double*, double*, size_t);
+	const char* (*findEither)(const char*, const char*, char, char);
+};
+
+// chooses the kernels for the running CPU; SUDOH_SIMD may be set to 'sse2' or 'none' to use
+// slower kernels, e.g. to compare results
+static Kernels chooseKernels()
+{
+	const char* level = std::getenv("SUDOH_SIMD");
+	bool allowSse = !level || std::strcmp(level, "none") != 0;
+	bool allowAvx = allowSse && (!level || std::strcmp(level, "sse2") != 0);
+#ifdef SIMD_X86
+	if (allowAvx && hasAvx2())
+	{
+		return { avxSum, avxMin, avxMax, avxDot, avxScale, avxAdd,
+			avxSubtract, avxMultiply, avxAxpy, avxFindEither };
+	}
+	if (allowSse)
+	{
+		return { sseSum, sseMin, sseMax, sseDot, sseScale, sseAdd,
+			sseSubtract, sseMultiply, sseAxpy, sseFindEither };
+	}
+#else
+	(void)allowAvx;
+#endif
+	return { plainSum, plainMin, plainMax, plainDot, plainScale, plainAdd,
+		plainSubtract, plainMultiply, plainAxpy, plainFindEither };
+}
+
+static const Kernels& kernels()
+{
+	static const Kernels chosen = chooseKernels();
+	return chosen;
+}
+
+// returns the sum of an array of numbers
+double simdSum(const double* data, size_t n)
+{
+	return kernels().sum(data, n);
+}
+
+// returns the smallest number of a non-empty array
+double simdMin(const double* data, size_t n)
+{
+	return kernels().min(data, n);
+}
+
+// returns the largest number of a non-empty array
+double simdMax(const double* data, size_t n)
+{
+	return kernels().max(data, n);
+}
+
+// returns the sum of the products of the numbers at the same positions of two arrays
+double simdDot(const double* a, const double* b, size_t n)
+{
+	return kernels().dot(a, b, n);
+}
+
+// multiplies every number of an array by a factor
+void simdScale(const double* data, double factor, double* out, size_t n)
+{
+	kernels().scale(data, factor, out, n);
+}
+
+// adds the numbers at the same positions of two arrays
+void simdAdd(const double* a, const double* b, double* out, size_t n)
+{
+	kernels().add(a, b, out, n);
+}
+
+// subtracts the numbers of the second array from the numbers at the same positions of the first
+void simdSubtract(const double* a, const double* b, double* out, size_t n)
+{
+	kernels().subtract(a, b, out, n);
+}
+
+// multiplies the numbers at the same positions of two arrays
+void simdMultiply(const double* a, const double* b, double* out, size_t n)
+{
+	kernels().multiply(a, b, out, n);
+}
+
+// adds every number of an array multiplied by a factor to the number at the same position of 'out'
+void simdAxpy(double factor, const double* data, double* out, size_t n)
+{
+	kernels().axpy(factor, data, out, n);
+}
+
+// returns the first position in [data, end) holding either of two characters, or 'end' if there is none
+const char* simdFindEither(const char* data, const char* end, char a, char b)
+{
+	return kernels().findEither(data, end, a, b);
+}
@@ -0,0 +1,21 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstddef>
+
+// kernels over contiguous arrays of numbers (or characters) used by the numeric list, matrix and file
+// procedures. Each kernel has an AVX2, an SSE2 and a plain version; the fastest one supported by the
+// running CPU is chosen the first time a kernel is used. Sums are computed in several lanes at once,
+// so the order in which numbers are added differs from a left-to-right loop
+double simdSum(const double* data, size_t n);
+double simdMin(const double* data, size_t n);
+double simdMax(const double* data, size_t n);
+double simdDot(const double* a, const double* b, size_t n);
+void simdScale(const double* data, double factor, double* out, size_t n);
+void simdAdd(const double* a, const double* b, double* out, size_t n);
+void simdSubtract(const double* a, const double* b, double* out, size_t n);
+void simdMultiply(const double* a, const double* b, double* out, size_t n);
+void simdAxpy(double factor, const double* data, double* out, size_t n);
+const char* simdFindEither(const char* data, const char* end, char a, char b);
+
+#endif
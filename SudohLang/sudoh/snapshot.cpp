@@ -0,0 +1,347 @@
+#include "snapshot.h"
+#include "object.h"
+#include "file_io.h"
+#include "runtime_ex.h"
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+
+// A snapshot file begins with MAGIC and VERSION, followed by a single value. Each value begins with a
+// one byte tag, followed by:
+// - numbers: 8 bytes
+// - strings: their length (8 bytes) and characters
+// - lists: their length and elements; lists of only numbers are written as NUMBER_LIST, with the numbers
+//   one after another so that they can be read at once
+// - objects: their number of fields and each key followed by its value
+// - matrices: their number of rows and columns, and their elements
+// - bytes: their length and contents
+// Lists, objects, matrices and bytes are numbered in the order they are first written; one which has
+// already been written (because it is held by more than one variable, or contains itself) is written as
+// REFERENCE and its number, so that it is shared again when the snapshot is loaded.
+// Numbers are written in the byte order of the machine, which VERSION also records
+static const char MAGIC[8] = { 'S', 'U', 'D', 'O', 'H', 'S', 'N', 'P' };
+static const uint32_t VERSION = 1;
+
+enum class Tag : uint8_t { null, falseVal, trueVal, number, string, list, numberList, object, matrix, reference, bytes };
+
+// +----------------------+
+// |   Saving snapshots   |
+// +----------------------+
+
+class SnapshotWriter
+{
+	std::string out;
+	// numbers of the lists, objects, matrices and bytes written so far
+	std::unordered_map<const void*, uint64_t> written;
+
+	template <typename T>
+	void write(const T& value)
+	{
+		out.append((const char*)&value, sizeof(T));
+	}
+
+	void writeTag(Tag tag)
+	{
+		out += (char)tag;
+	}
+
+	// writes a reference if a list, object, matrix or bytes was written before; otherwise numbers it
+	bool writtenBefore(const void* container)
+	{
+		auto found = written.find(container);
+		if (found != written.end())
+		{
+			writeTag(Tag::reference);
+			write(found->second);
+			return true;
+		}
+		written.emplace(container, (uint64_t)written.size());
+		return false;
+	}
+
+public:
+	SnapshotWriter()
+	{
+		out.append(MAGIC, sizeof(MAGIC));
+		write(VERSION);
+	}
+
+	void value(const Variable& var)
+	{
+		switch (var.type)
+		{
+		case Type::null:
+			writeTag(Tag::null);
+			break;
+		case Type::boolean:
+			writeTag(var.val.boolVal ? Tag::trueVal : Tag::falseVal);
+			break;
+		case Type::number:
+			writeTag(Tag::number);
+			write(var.val.numVal);
+			break;
+		case Type::string:
+		case Type::charRef:
+			writeTag(Tag::string);
+			write((uint64_t)var.str().length());
+			out += var.str();
+			break;
+		case Type::list:
+		{
+			const Variable::List& list = *var.val.listRef;
+			if (writtenBefore(&list))
+			{
+				break;
+			}
+			bool numbers = !list.empty();
+			for (const Variable& e : list)
+			{
+				if (e.type != Type::number)
+				{
+					numbers = false;
+					break;
+				}
+			}
+			writeTag(numbers ? Tag::numberList : Tag::list);
+			write((uint64_t)list.size());
+			for (const Variable& e : list)
+			{
+				if (numbers)
+				{
+					write(e.val.numVal);
+				}
+				else
+				{
+					value(e);
+				}
+			}
+			break;
+		}
+		case Type::object:
+		{
+			const Variable::Object& object = *var.val.objRef;
+			if (writtenBefore(&object))
+			{
+				break;
+			}
+			writeTag(Tag::object);
+			write((uint64_t)object.size());
+			for (const auto& field : object)
+			{
+				value(field.first);
+				value(field.second);
+			}
+			break;
+		}
+		case Type::matrix:
+		{
+			const Matrix& m = *var.val.matrixRef;
+			if (writtenBefore(&m))
+			{
+				break;
+			}
+			writeTag(Tag::matrix);
+			write((uint64_t)m.rows);
+			write((uint64_t)m.cols);
+			out.append((const char*)m.data.data(), m.data.size() * sizeof(double));
+			break;
+		}
+		case Type::bytes:
+		{
+			const Variable::Bytes& bytes = *var.val.bytesRef;
+			if (writtenBefore(&bytes))
+			{
+				break;
+			}
+			writeTag(Tag::bytes);
+			write((uint64_t)bytes.size());
+			out.append((const char*)bytes.data(), bytes.size());
+			break;
+		}
+		default:
+			runtimeException("cannot save type " + var.typeString());
+		}
+	}
+
+	const std::string& contents() const { return out; }
+};
+
+// writes a variable, and every list, object and matrix it holds, to a snapshot file
+void saveSnapshot(const Variable& var, const std::string& path)
+{
+	SnapshotWriter writer;
+	writer.value(var);
+	writeFile(path, writer.contents());
+}
+
+// +-----------------------+
+// |   Loading snapshots   |
+// +-----------------------+
+
+// reads a snapshot from a mapped file; the lengths read are checked against the size of the file so that
+// a damaged file is an error rather than undefined behaviour
+class SnapshotReader
+{
+	const std::string& path;
+	const char* pos;
+	const char* end;
+	// the lists, objects, matrices and bytes read so far, in the order they were numbered
+	std::vector<Variable> containers;
+
+	void invalid()
+	{
+		runtimeException("file '" + path + "' is not a valid snapshot");
+	}
+
+	// returns the next 'size' bytes of the file
+	const char* take(uint64_t size)
+	{
+		if ((uint64_t)(end - pos) < size)
+		{
+			invalid();
+		}
+		const char* taken = pos;
+		pos += size;
+		return taken;
+	}
+
+	template <typename T>
+	T read()
+	{
+		T value;
+		memcpy(&value, take(sizeof(T)), sizeof(T));
+		return value;
+	}
+
+	// reads the length of a list, string, etc. of elements of at least 'elementSize' bytes each
+	size_t readLength(size_t elementSize)
+	{
+		uint64_t length = read<uint64_t>();
+		if (length > (uint64_t)(end - pos) / elementSize)
+		{
+			invalid();
+		}
+		return (size_t)length;
+	}
+
+public:
+	SnapshotReader(const std::string& path, const MappedFile& file) : path(path), pos(file.begin()), end(file.end())
+	{
+		if (memcmp(take(sizeof(MAGIC)), MAGIC, sizeof(MAGIC)) != 0 || read<uint32_t>() != VERSION)
+		{
+			invalid();
+		}
+	}
+
+	Variable value()
+	{
+		switch ((Tag)read<uint8_t>())
+		{
+		case Tag::null:
+			return Variable();
+		case Tag::falseVal:
+			return false;
+		case Tag::trueVal:
+			return true;
+		case Tag::number:
+			return read<double>();
+		case Tag::string:
+		{
+			size_t length = readLength(1);
+			return std::string(take(length), length);
+		}
+		case Tag::list:
+		{
+			// lists (and objects) are numbered before their elements are read, as they may contain themselves
+			Variable::ListRef list = Variable::ListRef(Variable::List());
+			containers.push_back(list);
+			size_t length = readLength(1);
+			list->reserve(length);
+			for (size_t i = 0; i < length; i++)
+			{
+				list->push_back(value());
+			}
+			return list;
+		}
+		case Tag::numberList:
+		{
+			size_t length = readLength(sizeof(double));
+			const char* numbers = take(length * sizeof(double));
+			Variable::List list;
+			list.reserve(length);
+			for (size_t i = 0; i < length; i++)
+			{
+				double num;
+				memcpy(&num, numbers + i * sizeof(double), sizeof(double));
+				list.emplace_back(num);
+			}
+			Variable listVar = Variable::ListRef(std::move(list));
+			containers.push_back(listVar);
+			return listVar;
+		}
+		case Tag::object:
+		{
+			Variable::ObjectRef object = Variable::ObjectRef(Variable::Object());
+			containers.push_back(object);
+			size_t fields = readLength(2);
+			for (size_t i = 0; i < fields; i++)
+			{
+				Variable key = value();
+				(*object)[key] = value();
+			}
+			return object;
+		}
+		case Tag::matrix:
+		{
+			uint64_t rows = read<uint64_t>(), cols = read<uint64_t>();
+			if (cols != 0 && rows > (uint64_t)(end - pos) / sizeof(double) / cols)
+			{
+				invalid();
+			}
+			Matrix m((size_t)rows, (size_t)cols);
+			memcpy(m.data.data(), take(m.data.size() * sizeof(double)), m.data.size() * sizeof(double));
+			Variable matrixVar = Variable::MatrixRef(std::move(m));
+			containers.push_back(matrixVar);
+			return matrixVar;
+		}
+		case Tag::bytes:
+		{
+			size_t length = readLength(1);
+			const uint8_t* bytes = (const uint8_t*)take(length);
+			Variable bytesVar = Variable::BytesRef(Variable::Bytes(bytes, bytes + length));
+			containers.push_back(bytesVar);
+			return bytesVar;
+		}
+		case Tag::reference:
+		{
+			uint64_t index = read<uint64_t>();
+			if (index >= containers.size())
+			{
+				invalid();
+			}
+			return containers[(size_t)index];
+		}
+		default:
+			invalid();
+			return Variable();
+		}
+	}
+
+	void finish()
+	{
+		if (pos != end)
+		{
+			invalid();
+		}
+	}
+};
+
+// reads a variable from a snapshot file written by 'saveSnapshot'
+Variable loadSnapshot(const std::string& path)
+{
+	MappedFile file(path);
+	SnapshotReader reader(path, file);
+	Variable loaded = reader.value();
+	reader.finish();
+	return loaded;
+}
@@ -0,0 +1,9 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "variable.h"
+
+void saveSnapshot(const Variable& var, const std::string& path);
+Variable loadSnapshot(const std::string& path);
+
+#endif
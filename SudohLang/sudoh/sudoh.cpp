@@ -1,10 +1,18 @@
 #include "sudoh.h"
 #include "runtime_ex.h"
+#include "simd.h"
+#include "file_io.h"
+#include "csv.h"
+#include "json.h"
+#include "snapshot.h"
+#include "pattern.h"
 #include <iostream>
 #include <ctime>
 #include <cmath>
 #include <memory>
 #include <climits>
+#include <cstring>
+#include <cctype>
 
 // asserts that a variable is of the right type and returns its value
 template <typename T>
@@ -32,6 +40,33 @@ size_t assertPositiveInteger(const std::string& which, const std::string& proced
 	return val;
 }
 
+// specialized version of 'assertType' which verifies a list of numbers and copies them to 'out'
+std::vector<double>& assertNumberList(const std::string& which, const std::string& procedure,
+	const Variable& var, std::vector<double>& out)
+{
+	if (!Variable::numListCheck(var, out))
+	{
+		runtimeException("expected parameter '" + which + "' of procedure '" + procedure +
+			"' to be a list of numbers");
+	}
+	return out;
+}
+
+// specialized version of 'assertType' which verifies an integer which fits in a byte
+uint8_t assertByte(const std::string& which, const std::string& procedure, const Variable& var)
+{
+	size_t val;
+	if (!Variable::indexCheck(var, val) || val > UINT8_MAX)
+	{
+		runtimeException("expected parameter '" + which + "' of procedure '" + procedure +
+			"' to be an integer in the range [0, 255]");
+	}
+	return (uint8_t)val;
+}
+
+// buffers that numeric list procedures copy their parameters to, kept to avoid allocating each call
+thread_local std::vector<double> numbersA, numbersB;
+
 // returns user input as a string
 Variable p_input()
 {
@@ -64,7 +99,15 @@ Variable p_length(Variable var)
 	case Type::object:
 		return (double)var.val.objRef->size();
 	case Type::string:
-		return (double)var.val.stringVal.length();
+		return (double)var.val.stringRef->length();
+	case Type::charRef:
+		return 1;
+	case Type::matrix:
+		return (double)var.val.matrixRef->rows;
+	case Type::bytes:
+		return (double)var.val.bytesRef->size();
+	case Type::heap:
+		return (double)var.val.heapRef->size();
 	}
 	runtimeException("cannot take length of type " + var.typeString());
 	return null;
@@ -142,16 +185,14 @@ Variable p_remove(Variable var, Variable element)
 	else if (var.type == Type::object)
 	{
 		Variable::Object& o = *var.val.objRef;
-		if (element.type != Type::string)
+		if (!element.isString())
 		{
 			runtimeException("parameter 'index' of 'remove' on type 'object' must be a string");
 		}
-		auto e = o.find(element);
-		if (e == o.end())
+		if (!o.erase(element))
 		{
-			runtimeException("field of name " + element.val.stringVal + " cannot be removed from object as it does not exist in the object");
+			runtimeException("field of name " + element.str() + " cannot be removed from object as it does not exist in the object");
 		}
-		o.erase(e);
 		return null;
 	}
 
@@ -168,9 +209,15 @@ Variable p_removeLast(Variable list)
 	return null;
 }
 
-// appends a new element to a list
+// appends a new element to a list, or a byte to bytes
 Variable p_append(Variable list, Variable value)
 {
+	Variable::Bytes* bytes;
+	if (Variable::bytesCheck(list, bytes))
+	{
+		bytes->push_back(assertByte("value", "append", value));
+		return null;
+	}
 	Variable::List& l = *assertTypeGeneric("list", "append", "list", list, Variable::listCheck);
 	l.push_back(value);
 	return null;
@@ -193,38 +240,54 @@ Variable p_insert(Variable list, Variable index, Variable value)
 
 Variable p_range(Variable indexable, Variable begin, Variable end)
 {
-	size_t b = assertPositiveInteger("begin", "substring", begin);
-	size_t e = assertPositiveInteger("end", "substring", end);
+	size_t b = assertPositiveInteger("begin", "range", begin);
+	size_t e = assertPositiveInteger("end", "range", end);
 
-	if (indexable.type == Type::string)
+	if (indexable.isString())
 	{
-		const std::string& s = indexable.val.stringVal;
+		const std::string& s = indexable.str();
 
-		if (b >= s.length())
+		if (e > s.length())
 		{
-			runtimeException("parameter 'begin' of 'range' outside of string bounds");
+			runtimeException("parameter 'end' of 'range' outside of string bounds");
 		}
-		if (e >= s.length())
+		if (b > e)
 		{
-			runtimeException("parameter 'end' of 'range' outside of string bounds");
+			runtimeException("parameter 'begin' of 'range' after parameter 'end'");
 		}
 
-		return std::string(s.begin() + b, s.end() + e);
+		return s.substr(b, e - b);
 	}
 	else if (indexable.type == Type::list)
 	{
 		const Variable::List& l = *indexable.val.listRef;
 
-		if (b >= l.size())
+		if (e > l.size())
 		{
-			runtimeException("parameter 'begin' of 'range' outside of list bounds");
+			runtimeException("parameter 'end' of 'range' outside of list bounds");
 		}
-		if (e >= l.size())
+		if (b > e)
 		{
-			runtimeException("parameter 'end' of 'range' outside of list bounds");
+			runtimeException("parameter 'begin' of 'range' after parameter 'end'");
 		}
 
-		return std::make_shared<Variable::List>(Variable::List(l.begin() + b, l.begin() + e));
+		return Variable::ListRef(Variable::List(l.begin() + b, l.begin() + e));
+	}
+	else if (indexable.type == Type::bytes)
+	{
+		// a range of bytes is copied at once
+		const Variable::Bytes& bytes = *indexable.val.bytesRef;
+
+		if (e > bytes.size())
+		{
+			runtimeException("parameter 'end' of 'range' outside of bytes bounds");
+		}
+		if (b > e)
+		{
+			runtimeException("parameter 'begin' of 'range' after parameter 'end'");
+		}
+
+		return Variable::BytesRef(Variable::Bytes(bytes.begin() + b, bytes.begin() + e));
 	}
 
 	runtimeException("cannot take range of type " + indexable.typeString());
@@ -292,3 +355,723 @@ Variable p_log(Variable num, Variable base)
 	double b = assertTypeGeneric("base", "log", "number", base, Variable::numCheck);
 	return log(n) / log(b);
 }
+
+// clears the caches of all memoized procedures
+Variable p_clearMemo()
+{
+	MemoTable::clearAll();
+	return null;
+}
+
+// sets the maximum number of outputs cached for each memoized procedure (0 for no limit)
+Variable p_memoLimit(Variable size)
+{
+	MemoTable::limit.store(assertPositiveInteger("size", "memoLimit", size), std::memory_order_relaxed);
+	return null;
+}
+
+// returns an object containing the number of cache hits, misses, and entries of all memoized procedures
+Variable p_memoStats()
+{
+	size_t hits, misses, entries;
+	MemoTable::stats(hits, misses, entries);
+
+	return OBJECT{
+		{ std::string("hits"), (double)hits },
+		{ std::string("misses"), (double)misses },
+		{ std::string("entries"), (double)entries }
+	};
+}
+
+// waits for a task started with 'spawn' to finish and returns the output of its procedure call
+Variable p_await(Variable task)
+{
+	return assertTypeGeneric("task", "await", "task", task, Variable::taskCheck)->await();
+}
+
+// creates a channel which holds up to 'capacity' values sent but not yet received
+Variable p_channel(Variable capacity)
+{
+	size_t n = assertPositiveInteger("capacity", "channel", capacity);
+	if (n == 0)
+	{
+		runtimeException("parameter 'capacity' of 'channel' must be at least 1");
+	}
+	return std::make_shared<Channel>(n);
+}
+
+// sends a value through a channel, waiting while the channel is full
+Variable p_send(Variable channel, Variable value)
+{
+	assertTypeGeneric("channel", "send", "channel", channel, Variable::channelCheck)->send(std::move(value));
+	return null;
+}
+
+// receives a value from a channel, waiting while the channel is empty
+Variable p_receive(Variable channel)
+{
+	return assertTypeGeneric("channel", "receive", "channel", channel, Variable::channelCheck)->receive();
+}
+
+// closes a channel; no more values may be sent through it
+Variable p_close(Variable channel)
+{
+	assertTypeGeneric("channel", "close", "channel", channel, Variable::channelCheck)->close();
+	return null;
+}
+
+// asserts that a priority of a value in a heap is a number which can be compared with others
+static double assertPriority(const std::string& procedure, const Variable& priority)
+{
+	double p = assertTypeGeneric("priority", procedure, "number", priority, Variable::numCheck);
+	if (std::isnan(p))
+	{
+		runtimeException("parameter 'priority' of '" + procedure + "' must not be NaN");
+	}
+	return p;
+}
+
+// creates an empty heap, from which values are popped in order of priority (lowest first)
+Variable p_heap()
+{
+	return Variable::HeapRef::make();
+}
+
+// adds a value to a heap with a priority, returning a handle to the value for 'decreasePriority'
+Variable p_push(Variable heap, Variable priority, Variable value)
+{
+	Heap* h = assertTypeGeneric("heap", "push", "heap", heap, Variable::heapCheck);
+	return h->push(assertPriority("push", priority), std::move(value));
+}
+
+// removes and returns the value with the lowest priority in a heap
+Variable p_pop(Variable heap)
+{
+	return assertTypeGeneric("heap", "pop", "heap", heap, Variable::heapCheck)->pop();
+}
+
+// returns the value with the lowest priority in a heap without removing it
+Variable p_peek(Variable heap)
+{
+	return assertTypeGeneric("heap", "peek", "heap", heap, Variable::heapCheck)->peek();
+}
+
+// lowers the priority of a value in a heap, given the handle returned when the value was pushed
+Variable p_decreasePriority(Variable heap, Variable handle, Variable priority)
+{
+	Heap* h = assertTypeGeneric("heap", "decreasePriority", "heap", heap, Variable::heapCheck);
+	double n = assertTypeGeneric("handle", "decreasePriority", "number", handle, Variable::numCheck);
+	h->decrease(n, assertPriority("decreasePriority", priority));
+	return null;
+}
+
+// returns the sum of a list of numbers
+Variable p_sum(Variable list)
+{
+	const std::vector<double>& nums = assertNumberList("list", "sum", list, numbersA);
+	return simdSum(nums.data(), nums.size());
+}
+
+// returns the smallest number of a non-empty list of numbers
+Variable p_min(Variable list)
+{
+	const std::vector<double>& nums = assertNumberList("list", "min", list, numbersA);
+	if (nums.empty())
+	{
+		runtimeException("cannot take 'min' of an empty list");
+	}
+	return simdMin(nums.data(), nums.size());
+}
+
+// returns the largest number of a non-empty list of numbers
+Variable p_max(Variable list)
+{
+	const std::vector<double>& nums = assertNumberList("list", "max", list, numbersA);
+	if (nums.empty())
+	{
+		runtimeException("cannot take 'max' of an empty list");
+	}
+	return simdMax(nums.data(), nums.size());
+}
+
+// returns the average of a non-empty list of numbers
+Variable p_mean(Variable list)
+{
+	const std::vector<double>& nums = assertNumberList("list", "mean", list, numbersA);
+	if (nums.empty())
+	{
+		runtimeException("cannot take 'mean' of an empty list");
+	}
+	return simdSum(nums.data(), nums.size()) / nums.size();
+}
+
+// returns the sum of the products of the numbers at the same indices of two lists of equal length
+Variable p_dot(Variable list1, Variable list2)
+{
+	const std::vector<double>& a = assertNumberList("list1", "dot", list1, numbersA);
+	const std::vector<double>& b = assertNumberList("list2", "dot", list2, numbersB);
+	if (a.size() != b.size())
+	{
+		runtimeException("cannot take 'dot' of lists of different lengths");
+	}
+	return simdDot(a.data(), b.data(), a.size());
+}
+
+// converts an array of numbers to a list
+static Variable numbersToList(const double* nums, size_t n)
+{
+	Variable::List list;
+	list.reserve(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		list.emplace_back(nums[i]);
+	}
+	return Variable::ListRef(std::move(list));
+}
+
+// returns a new list with every number of a list multiplied by a factor
+Variable p_scale(Variable list, Variable factor)
+{
+	double f = assertTypeGeneric("factor", "scale", "number", factor, Variable::numCheck);
+	std::vector<double>& nums = assertNumberList("list", "scale", list, numbersA);
+	simdScale(nums.data(), f, nums.data(), nums.size());
+	return numbersToList(nums.data(), nums.size());
+}
+
+// returns a new list with the sums of the numbers at the same indices of two lists of equal length
+Variable p_addLists(Variable list1, Variable list2)
+{
+	const std::vector<double>& a = assertNumberList("list1", "addLists", list1, numbersA);
+	const std::vector<double>& b = assertNumberList("list2", "addLists", list2, numbersB);
+	if (a.size() != b.size())
+	{
+		runtimeException("cannot take 'addLists' of lists of different lengths");
+	}
+	simdAdd(a.data(), b.data(), numbersA.data(), a.size());
+	return numbersToList(numbersA.data(), numbersA.size());
+}
+
+// creates a matrix of numbers with every element set to 'fill'
+Variable p_matrix(Variable rows, Variable columns, Variable fill)
+{
+	size_t r = assertPositiveInteger("rows", "matrix", rows);
+	size_t c = assertPositiveInteger("columns", "matrix", columns);
+	double f = assertTypeGeneric("fill", "matrix", "number", fill, Variable::numCheck);
+	return Variable::MatrixRef(Matrix(r, c, f));
+}
+
+// creates a matrix from a list of lists of numbers of equal length, each of which is a row
+Variable p_toMatrix(Variable list)
+{
+	Variable::List* rows = assertTypeGeneric("list", "toMatrix", "list", list, Variable::listCheck);
+	Matrix m(rows->size(), 0);
+	for (size_t r = 0; r < rows->size(); r++)
+	{
+		const std::vector<double>& row = assertNumberList("list", "toMatrix", (*rows)[r], numbersA);
+		if (r == 0)
+		{
+			m.cols = row.size();
+			m.data.reserve(m.rows * m.cols);
+		}
+		else if (row.size() != m.cols)
+		{
+			runtimeException("rows of parameter 'list' of procedure 'toMatrix' must have the same length");
+		}
+		m.data.insert(m.data.end(), row.begin(), row.end());
+	}
+	return Variable::MatrixRef(std::move(m));
+}
+
+// converts a matrix to a list of lists of numbers, each of which is a row
+Variable p_toList(Variable matrix)
+{
+	const Matrix& m = *assertTypeGeneric("matrix", "toList", "matrix", matrix, Variable::matrixCheck);
+	Variable::List rows;
+	rows.reserve(m.rows);
+	for (size_t r = 0; r < m.rows; r++)
+	{
+		rows.emplace_back(numbersToList(&m.data[r * m.cols], m.cols));
+	}
+	return Variable::ListRef(std::move(rows));
+}
+
+// returns the number of rows of a matrix
+Variable p_rows(Variable matrix)
+{
+	return (double)assertTypeGeneric("matrix", "rows", "matrix", matrix, Variable::matrixCheck)->rows;
+}
+
+// returns the number of columns of a matrix
+Variable p_columns(Variable matrix)
+{
+	return (double)assertTypeGeneric("matrix", "columns", "matrix", matrix, Variable::matrixCheck)->cols;
+}
+
+// returns a new matrix with the rows and columns of a matrix swapped
+Variable p_transpose(Variable matrix)
+{
+	return Variable::MatrixRef(assertTypeGeneric("matrix", "transpose", "matrix", matrix, Variable::matrixCheck)->transposed());
+}
+
+// returns the matrix product of two matrices
+Variable p_multiply(Variable matrix1, Variable matrix2)
+{
+	Matrix* a = assertTypeGeneric("matrix1", "multiply", "matrix", matrix1, Variable::matrixCheck);
+	Matrix* b = assertTypeGeneric("matrix2", "multiply", "matrix", matrix2, Variable::matrixCheck);
+	return Variable::MatrixRef(a->product(*b));
+}
+
+// returns a new matrix with the products of the elements at the same position of two matrices of equal size
+Variable p_multiplyElements(Variable matrix1, Variable matrix2)
+{
+	Matrix* a = assertTypeGeneric("matrix1", "multiplyElements", "matrix", matrix1, Variable::matrixCheck);
+	Matrix* b = assertTypeGeneric("matrix2", "multiplyElements", "matrix", matrix2, Variable::matrixCheck);
+	a->assertSameSize(*b, "multiplyElements");
+	return Variable::MatrixRef(a->combined(*b, simdMultiply));
+}
+
+// returns the contents of a file as a string
+Variable p_readFile(Variable path)
+{
+	return readFile(*assertTypeGeneric("path", "readFile", "string", path, Variable::stringCheck));
+}
+
+// reads the contents of a file as bytes
+Variable p_readBytes(Variable path)
+{
+	MappedFile file(*assertTypeGeneric("path", "readBytes", "string", path, Variable::stringCheck));
+	return Variable::BytesRef(Variable::Bytes(file.begin(), file.end()));
+}
+
+// replaces the contents of a file (creating it if needed) with bytes, or a string representation of a variable
+Variable p_writeFile(Variable path, Variable contents)
+{
+	const std::string& p = *assertTypeGeneric("path", "writeFile", "string", path, Variable::stringCheck);
+	Variable::Bytes* bytes;
+	if (Variable::bytesCheck(contents, bytes))
+	{
+		writeFile(p, (const char*)bytes->data(), bytes->size());
+	}
+	else
+	{
+		writeFile(p, contents.toString());
+	}
+	return null;
+}
+
+// adds bytes, or a string representation of a variable, to the end of a file (creating it if needed)
+Variable p_appendFile(Variable path, Variable contents)
+{
+	const std::string& p = *assertTypeGeneric("path", "appendFile", "string", path, Variable::stringCheck);
+	Variable::Bytes* bytes;
+	if (Variable::bytesCheck(contents, bytes))
+	{
+		appendFile(p, (const char*)bytes->data(), bytes->size());
+	}
+	else
+	{
+		appendFile(p, contents.toString());
+	}
+	return null;
+}
+
+// returns the lines of a file, which are read one at a time by a 'for each' loop
+Variable p_lines(Variable path)
+{
+	return std::make_shared<FileLines>(*assertTypeGeneric("path", "lines", "string", path, Variable::stringCheck));
+}
+
+// reads a CSV file with a header row into an object mapping the name of each column to a list of its values
+Variable p_readCSV(Variable path)
+{
+	return readCSV(*assertTypeGeneric("path", "readCSV", "string", path, Variable::stringCheck), CSVOptions());
+}
+
+// reads a CSV file as above with options given by the fields of an object: "delimiter" (a single character),
+// "header" (whether the first row holds the names of the columns) and "columns" (a list of the columns to read)
+Variable p_readCSV(Variable path, Variable options)
+{
+	const std::string& p = *assertTypeGeneric("path", "readCSV", "string", path, Variable::stringCheck);
+	const Variable::Object& opts = *assertTypeGeneric("options", "readCSV", "object", options, Variable::objectCheck);
+	CSVOptions csv;
+	for (const auto& option : opts)
+	{
+		const std::string& name = *assertTypeGeneric("options", "readCSV", "object", option.first, Variable::stringCheck);
+		if (name == "delimiter")
+		{
+			const std::string& d = *assertTypeGeneric("delimiter", "readCSV", "string", option.second, Variable::stringCheck);
+			if (d.length() != 1 || d[0] == '\n' || d[0] == '"')
+			{
+				runtimeException("option 'delimiter' of procedure 'readCSV' must be a single character other than a "
+					"quote or newline");
+			}
+			csv.delimiter = d[0];
+		}
+		else if (name == "header")
+		{
+			csv.header = assertTypeGeneric("header", "readCSV", "boolean", option.second, Variable::boolCheck);
+		}
+		else if (name == "columns")
+		{
+			Variable::List* columns = assertTypeGeneric("columns", "readCSV", "list", option.second, Variable::listCheck);
+			for (const Variable& column : *columns)
+			{
+				csv.columns.push_back(*assertTypeGeneric("columns", "readCSV", "list of strings", column, Variable::stringCheck));
+			}
+		}
+		else
+		{
+			runtimeException("unknown option '" + name + "' of procedure 'readCSV'");
+		}
+	}
+	return readCSV(p, csv);
+}
+
+// converts JSON text to a variable; arrays become lists and objects become objects
+Variable p_parseJSON(Variable text)
+{
+	return parseJSON(*assertTypeGeneric("text", "parseJSON", "string", text, Variable::stringCheck));
+}
+
+// converts a variable to JSON text
+Variable p_toJSON(Variable var)
+{
+	return toJSON(var);
+}
+
+// writes a variable, with the lists, objects and matrices it holds, to a binary snapshot file
+Variable p_save(Variable var, Variable path)
+{
+	saveSnapshot(var, *assertTypeGeneric("path", "save", "string", path, Variable::stringCheck));
+	return null;
+}
+
+// reads a variable from a snapshot file written by 'save'
+Variable p_load(Variable path)
+{
+	return loadSnapshot(*assertTypeGeneric("path", "load", "string", path, Variable::stringCheck));
+}
+
+// returns new bytes of a length, all zero
+Variable p_bytes(Variable length)
+{
+	return Variable::BytesRef(Variable::Bytes(assertPositiveInteger("length", "bytes", length), 0));
+}
+
+// returns the characters of a string as bytes
+Variable p_bytesFromString(Variable str)
+{
+	const std::string& s = *assertTypeGeneric("str", "bytesFromString", "string", str, Variable::stringCheck);
+	return Variable::BytesRef(Variable::Bytes(s.begin(), s.end()));
+}
+
+// returns bytes as a string of the characters they hold
+Variable p_toString(Variable bytes)
+{
+	const Variable::Bytes& b = *assertTypeGeneric("bytes", "toString", "bytes", bytes, Variable::bytesCheck);
+	return std::string(b.begin(), b.end());
+}
+
+// returns the first occurrence of a pattern in [begin, end), or null if there is none; candidates are
+// found by searching for the first character of the pattern with memchr, which scans many bytes at once
+static const char* findPattern(const char* begin, const char* end, const char* pattern, size_t length)
+{
+	if (length == 0)
+	{
+		return begin;
+	}
+	if ((size_t)(end - begin) < length)
+	{
+		return nullptr;
+	}
+	const char* last = end - length;
+	while (begin <= last)
+	{
+		begin = (const char*)memchr(begin, pattern[0], last - begin + 1);
+		if (!begin)
+		{
+			return nullptr;
+		}
+		if (memcmp(begin + 1, pattern + 1, length - 1) == 0)
+		{
+			return begin;
+		}
+		begin++;
+	}
+	return nullptr;
+}
+
+// sets 'data' and 'size' to the characters of a string or bytes, returning false if it is neither
+static bool textCheck(const Variable& var, const char*& data, size_t& size)
+{
+	const std::string* s;
+	Variable::Bytes* b;
+	if (Variable::stringCheck(var, s))
+	{
+		data = s->data();
+		size = s->length();
+		return true;
+	}
+	if (Variable::bytesCheck(var, b))
+	{
+		data = (const char*)b->data();
+		size = b->size();
+		return true;
+	}
+	return false;
+}
+
+// returns the index of the first occurrence of a pattern (a string or bytes) in a string or bytes at or after
+// 'start', or -1 if there is none
+Variable p_find(Variable text, Variable pattern, Variable start)
+{
+	const char* data;
+	const char* p;
+	size_t size, length;
+	if (!textCheck(text, data, size))
+	{
+		runtimeException("expected parameter 'text' of procedure 'find' to be of type 'string' or 'bytes'");
+	}
+	if (!textCheck(pattern, p, length))
+	{
+		runtimeException("expected parameter 'pattern' of procedure 'find' to be of type 'string' or 'bytes'");
+	}
+	size_t from = assertPositiveInteger("start", "find", start);
+
+	if (from > size)
+	{
+		return -1;
+	}
+	const char* found = findPattern(data + from, data + size, p, length);
+	return found ? (double)(found - data) : -1;
+}
+
+// returns the index of the first occurrence of a pattern in a string or bytes, or -1 if there is none
+Variable p_find(Variable text, Variable pattern)
+{
+	return p_find(text, pattern, 0);
+}
+
+// splits a string into a list of the parts between occurrences of a separator
+Variable p_split(Variable str, Variable separator)
+{
+	const std::string& s = *assertTypeGeneric("str", "split", "string", str, Variable::stringCheck);
+	const std::string& sep = *assertTypeGeneric("separator", "split", "string", separator, Variable::stringCheck);
+	if (sep.empty())
+	{
+		runtimeException("parameter 'separator' of 'split' is an empty string");
+	}
+
+	Variable::List parts;
+	const char* pos = s.data();
+	const char* end = pos + s.length();
+	while (const char* found = findPattern(pos, end, sep.data(), sep.length()))
+	{
+		parts.emplace_back(std::string(pos, found));
+		pos = found + sep.length();
+	}
+	parts.emplace_back(std::string(pos, end));
+	return Variable::ListRef(std::move(parts));
+}
+
+// joins a list of strings into one string, with a separator between each; the length of the output is
+// counted first so that it is allocated once
+Variable p_join(Variable list, Variable separator)
+{
+	const Variable::List& l = *assertTypeGeneric("list", "join", "list", list, Variable::listCheck);
+	const std::string& sep = *assertTypeGeneric("separator", "join", "string", separator, Variable::stringCheck);
+
+	size_t length = l.empty() ? 0 : sep.length() * (l.size() - 1);
+	for (const Variable& e : l)
+	{
+		const std::string* part;
+		if (!Variable::stringCheck(e, part))
+		{
+			runtimeException("cannot join list containing type " + e.typeString());
+		}
+		length += part->length();
+	}
+
+	std::string out;
+	out.reserve(length);
+	for (size_t i = 0; i < l.size(); i++)
+	{
+		const std::string* part;
+		Variable::stringCheck(l[i], part);
+		if (i > 0)
+		{
+			out += sep;
+		}
+		out += *part;
+	}
+	return out;
+}
+
+// returns a string with every occurrence of 'old' replaced by 'replacement'
+Variable p_replace(Variable str, Variable old, Variable replacement)
+{
+	const std::string& s = *assertTypeGeneric("str", "replace", "string", str, Variable::stringCheck);
+	const std::string& o = *assertTypeGeneric("old", "replace", "string", old, Variable::stringCheck);
+	const std::string& r = *assertTypeGeneric("replacement", "replace", "string", replacement, Variable::stringCheck);
+	if (o.empty())
+	{
+		runtimeException("parameter 'old' of 'replace' is an empty string");
+	}
+
+	const char* pos = s.data();
+	const char* end = pos + s.length();
+	const char* found = findPattern(pos, end, o.data(), o.length());
+	if (!found)
+	{
+		// the string is shared rather than copied if nothing is replaced
+		return str;
+	}
+	std::string out;
+	out.reserve(s.length());
+	do
+	{
+		out.append(pos, found);
+		out += r;
+		pos = found + o.length();
+	} while ((found = findPattern(pos, end, o.data(), o.length())));
+	out.append(pos, end);
+	return out;
+}
+
+// returns whether a string begins with a prefix
+Variable p_startsWith(Variable str, Variable prefix)
+{
+	const std::string& s = *assertTypeGeneric("str", "startsWith", "string", str, Variable::stringCheck);
+	const std::string& p = *assertTypeGeneric("prefix", "startsWith", "string", prefix, Variable::stringCheck);
+	return s.compare(0, p.length(), p) == 0;
+}
+
+// returns whether a string ends with a suffix
+Variable p_endsWith(Variable str, Variable suffix)
+{
+	const std::string& s = *assertTypeGeneric("str", "endsWith", "string", str, Variable::stringCheck);
+	const std::string& p = *assertTypeGeneric("suffix", "endsWith", "string", suffix, Variable::stringCheck);
+	return s.length() >= p.length() && s.compare(s.length() - p.length(), p.length(), p) == 0;
+}
+
+// returns a string without the whitespace at its beginning and end
+Variable p_trim(Variable str)
+{
+	const std::string& s = *assertTypeGeneric("str", "trim", "string", str, Variable::stringCheck);
+	size_t b = 0, e = s.length();
+	while (b < e && isspace((unsigned char)s[b]))
+	{
+		b++;
+	}
+	while (e > b && isspace((unsigned char)s[e - 1]))
+	{
+		e--;
+	}
+	if (b == 0 && e == s.length())
+	{
+		return str;
+	}
+	return s.substr(b, e - b);
+}
+
+// returns whether a pattern matches any part of a string
+Variable p_matches(Variable str, Variable pattern)
+{
+	const std::string& s = *assertTypeGeneric("str", "matches", "string", str, Variable::stringCheck);
+	std::shared_ptr<Pattern> p = Pattern::compiled(
+		*assertTypeGeneric("pattern", "matches", "string", pattern, Variable::stringCheck));
+	const char* matchBegin;
+	const char* matchEnd;
+	return p->search(s.data(), s.data() + s.length(), s.data(), matchBegin, matchEnd);
+}
+
+// calls 'found' with the beginning and end of each match of a pattern in a string, in order and without
+// overlapping; after a match of no characters, the next match is searched for from the following character
+template <typename F>
+static void eachMatch(Pattern& p, const std::string& s, F found)
+{
+	const char* begin = s.data();
+	const char* end = begin + s.length();
+	const char* from = begin;
+	const char* matchBegin;
+	const char* matchEnd;
+	while (p.search(begin, end, from, matchBegin, matchEnd))
+	{
+		found(matchBegin, matchEnd);
+		if (matchBegin != matchEnd)
+		{
+			from = matchEnd;
+		}
+		else if (matchEnd != end)
+		{
+			from = matchEnd + 1;
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+// returns a list of the parts of a string matched by a pattern
+Variable p_findAll(Variable str, Variable pattern)
+{
+	const std::string& s = *assertTypeGeneric("str", "findAll", "string", str, Variable::stringCheck);
+	std::shared_ptr<Pattern> p = Pattern::compiled(
+		*assertTypeGeneric("pattern", "findAll", "string", pattern, Variable::stringCheck));
+	Variable::List found;
+	eachMatch(*p, s, [&](const char* matchBegin, const char* matchEnd)
+	{
+		found.emplace_back(std::string(matchBegin, matchEnd));
+	});
+	return Variable::ListRef(std::move(found));
+}
+
+// returns a string with each part matched by a pattern replaced by 'replacement'
+Variable p_replaceAll(Variable str, Variable pattern, Variable replacement)
+{
+	const std::string& s = *assertTypeGeneric("str", "replaceAll", "string", str, Variable::stringCheck);
+	std::shared_ptr<Pattern> p = Pattern::compiled(
+		*assertTypeGeneric("pattern", "replaceAll", "string", pattern, Variable::stringCheck));
+	const std::string& r = *assertTypeGeneric("replacement", "replaceAll", "string", replacement,
+		Variable::stringCheck);
+
+	std::string out;
+	const char* copied = s.data();
+	bool replaced = false;
+	eachMatch(*p, s, [&](const char* matchBegin, const char* matchEnd)
+	{
+		out.append(copied, matchBegin);
+		out += r;
+		copied = matchEnd;
+		replaced = true;
+	});
+	if (!replaced)
+	{
+		return str;
+	}
+	out.append(copied, s.data() + s.length());
+	return out;
+}
+
+// returns a string with its letters in upper case
+Variable p_toUpper(Variable str)
+{
+	std::string s = *assertTypeGeneric("str", "toUpper", "string", str, Variable::stringCheck);
+	for (char& c : s)
+	{
+		c = (char)toupper((unsigned char)c);
+	}
+	return s;
+}
+
+// returns a string with its letters in lower case
+Variable p_toLower(Variable str)
+{
+	std::string s = *assertTypeGeneric("str", "toLower", "string", str, Variable::stringCheck);
+	for (char& c : s)
+	{
+		c = (char)tolower((unsigned char)c);
+	}
+	return s;
+}
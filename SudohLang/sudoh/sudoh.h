@@ -2,9 +2,22 @@
 #define SUDOH_H
 
 #include "variable.h"
+#include "object.h"
+#include "memo.h"
+#include "profiler.h"
+#include "line_counter.h"
+#include "sampler.h"
+#include "parallel.h"
+#include "task.h"
+#include "channel.h"
+#include "heap.h"
 
-#define LIST (std::shared_ptr<Variable::List>)new Variable::List
-#define OBJECT (std::shared_ptr<Variable::Object>)new Variable::Object
+#define LIST (Variable::ListRef)Variable::List
+#define OBJECT (Variable::ObjectRef)Variable::Object
+// the shape of the objects made by an object literal, and an index into an object by a string literal; each
+// is created once for the place in the program it is used
+#define SHAPE(...) ([]() -> const Shape* { static const Shape* shape = Shape::get({ __VA_ARGS__ }); return shape; }())
+#define FIELD(key) ([]() -> const FieldKey& { static const FieldKey field(key); return field; }())
 
 const Variable null = Variable();
 
@@ -36,4 +49,65 @@ Variable p_atan(Variable num);
 Variable p_atan2(Variable num1, Variable num2);
 Variable p_log(Variable num, Variable base);
 
+Variable p_clearMemo();
+Variable p_memoLimit(Variable size);
+Variable p_memoStats();
+
+Variable p_await(Variable task);
+Variable p_channel(Variable capacity);
+Variable p_send(Variable channel, Variable value);
+Variable p_receive(Variable channel);
+Variable p_close(Variable channel);
+
+Variable p_heap();
+Variable p_push(Variable heap, Variable priority, Variable value);
+Variable p_pop(Variable heap);
+Variable p_peek(Variable heap);
+Variable p_decreasePriority(Variable heap, Variable handle, Variable priority);
+
+Variable p_sum(Variable list);
+Variable p_min(Variable list);
+Variable p_max(Variable list);
+Variable p_mean(Variable list);
+Variable p_dot(Variable list1, Variable list2);
+Variable p_scale(Variable list, Variable factor);
+Variable p_addLists(Variable list1, Variable list2);
+
+Variable p_matrix(Variable rows, Variable columns, Variable fill);
+Variable p_toMatrix(Variable list);
+Variable p_toList(Variable matrix);
+Variable p_rows(Variable matrix);
+Variable p_columns(Variable matrix);
+Variable p_transpose(Variable matrix);
+Variable p_multiply(Variable matrix1, Variable matrix2);
+Variable p_multiplyElements(Variable matrix1, Variable matrix2);
+
+Variable p_readFile(Variable path);
+Variable p_readBytes(Variable path);
+Variable p_writeFile(Variable path, Variable contents);
+Variable p_appendFile(Variable path, Variable contents);
+Variable p_lines(Variable path);
+Variable p_readCSV(Variable path);
+Variable p_readCSV(Variable path, Variable options);
+Variable p_parseJSON(Variable text);
+Variable p_toJSON(Variable var);
+Variable p_save(Variable var, Variable path);
+Variable p_load(Variable path);
+Variable p_bytes(Variable length);
+Variable p_bytesFromString(Variable str);
+Variable p_toString(Variable bytes);
+Variable p_find(Variable text, Variable pattern);
+Variable p_find(Variable text, Variable pattern, Variable start);
+Variable p_split(Variable str, Variable separator);
+Variable p_join(Variable list, Variable separator);
+Variable p_replace(Variable str, Variable old, Variable replacement);
+Variable p_startsWith(Variable str, Variable prefix);
+Variable p_endsWith(Variable str, Variable suffix);
+Variable p_trim(Variable str);
+Variable p_toUpper(Variable str);
+Variable p_toLower(Variable str);
+Variable p_matches(Variable str, Variable pattern);
+Variable p_findAll(Variable str, Variable pattern);
+Variable p_replaceAll(Variable str, Variable pattern, Variable replacement);
+
 #endif
@@ -0,0 +1,47 @@
+#include "task.h"
+#include "thread_pool.h"
+
+Task::Task(std::function<Variable()> procCall) : call(procCall), state(pending) {}
+
+// runs the task on the current thread unless another thread has already started it
+bool Task::tryRun()
+{
+	int expected = pending;
+	if (!state.compare_exchange_strong(expected, running))
+	{
+		return false;
+	}
+
+	output = call();
+	call = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(finishLock);
+		state.store(done);
+	}
+	finished.notify_all();
+	return true;
+}
+
+// waits for the task to finish and returns its output. The waiting thread blocks rather than running
+// other tasks in the meantime, as those may only be able to finish once the task it waits for has
+Variable Task::await()
+{
+	if (!tryRun())
+	{
+		if (state.load() != done)
+		{
+			ThreadPool::instance().beginBlocking();
+			std::unique_lock<std::mutex> lock(finishLock);
+			finished.wait(lock, [this]() { return state.load() == done; });
+		}
+		mergeQueuedRefs();
+	}
+	return output;
+}
+
+Variable startTask(std::function<Variable()> procCall)
+{
+	std::shared_ptr<Task> task = std::make_shared<Task>(procCall);
+	ThreadPool::instance().submit([task]() { task->tryRun(); });
+	return task;
+}
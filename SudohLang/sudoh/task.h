@@ -0,0 +1,39 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include "variable.h"
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+// a procedure call started with 'spawn', which is run by the thread pool. A task which has not been
+// started by the time it is awaited is run by the awaiting thread instead
+struct Task
+{
+	enum State { pending, running, done };
+
+	std::function<Variable()> call;
+	std::atomic<int> state;
+	Variable output;
+
+	// signalled when the task is done, for threads awaiting it while it runs on another thread
+	std::mutex finishLock;
+	std::condition_variable finished;
+
+	Task(std::function<Variable()> procCall);
+	bool tryRun();
+	Variable await();
+};
+
+Variable startTask(std::function<Variable()> procCall);
+
+// starts a task which calls a procedure with the given parameters; 'spawn f(a, b)' is transpiled to
+// 'spawnTask((var(*)(var, var))p_f, a, b)', which picks out the procedure f with 2 parameters
+template <typename Proc, typename... Params>
+Variable spawnTask(Proc proc, Params... params)
+{
+	return startTask([=]() { return proc(params...); });
+}
+
+#endif
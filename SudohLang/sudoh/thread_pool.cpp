@@ -0,0 +1,145 @@
+#include "thread_pool.h"
+#include "ref.h"
+#include <thread>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+
+// maximum number of spare workers started for blocked threads
+constexpr size_t MAX_SPARE_WORKERS = 256;
+
+// index of the queue of the current thread; 0 for threads which are not workers of the pool
+static thread_local size_t queueIndex = 0;
+
+ThreadPool::ThreadPool() : numQueues(1), queued(0), idle(0)
+{
+	const char* threads = getenv("SUDOH_THREADS");
+	long n = threads ? strtol(threads, nullptr, 10) : 0;
+	numThreads = n > 0 ? (size_t)n : std::max(1u, std::thread::hardware_concurrency());
+
+	// queues are all allocated up front so that workers can be started while others are stealing
+	for (size_t i = 0; i < numThreads + MAX_SPARE_WORKERS; i++)
+	{
+		queues.emplace_back(new TaskQueue());
+	}
+	// the thread waiting for parallel work to finish also runs tasks, so one fewer worker is needed
+	for (size_t i = 1; i < numThreads; i++)
+	{
+		startWorker();
+	}
+}
+
+void ThreadPool::startWorker()
+{
+	size_t index = numQueues.load();
+	do
+	{
+		if (index == queues.size())
+		{
+			return;
+		}
+	} while (!numQueues.compare_exchange_weak(index, index + 1));
+	std::thread(&ThreadPool::runWorker, this, index).detach();
+}
+
+// the pool is never destroyed, as workers may still be running while the program exits
+ThreadPool& ThreadPool::instance()
+{
+	static ThreadPool* pool = new ThreadPool();
+	return *pool;
+}
+
+size_t ThreadPool::size() const
+{
+	return numThreads;
+}
+
+void ThreadPool::runWorker(size_t index)
+{
+	queueIndex = index;
+	while (true)
+	{
+		if (!runPendingTask())
+		{
+			std::unique_lock<std::mutex> lock(sleepLock);
+			idle++;
+			wake.wait(lock, [this]() { return queued.load() != 0; });
+			idle--;
+		}
+	}
+}
+
+// adds a task to the current thread's queue and wakes a worker to run (or steal) it
+void ThreadPool::submit(PoolTask task)
+{
+	TaskQueue& q = *queues[queueIndex];
+	{
+		std::lock_guard<std::mutex> lock(q.lock);
+		q.tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> lock(sleepLock);
+		queued++;
+	}
+	wake.notify_one();
+}
+
+// takes the newest task from the current thread's queue, or else steals the oldest task of another queue
+bool ThreadPool::takeTask(PoolTask& task)
+{
+	if (queued.load() == 0)
+	{
+		return false;
+	}
+
+	TaskQueue& own = *queues[queueIndex];
+	{
+		std::lock_guard<std::mutex> lock(own.lock);
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			queued--;
+			return true;
+		}
+	}
+
+	size_t n = numQueues.load();
+	for (size_t i = 1; i < n; i++)
+	{
+		TaskQueue& victim = *queues[(queueIndex + i) % n];
+		std::lock_guard<std::mutex> lock(victim.lock);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			queued--;
+			return true;
+		}
+	}
+	return false;
+}
+
+// runs one task on the current thread; returns false if there were no tasks to run
+bool ThreadPool::runPendingTask()
+{
+	PoolTask task;
+	if (!takeTask(task))
+	{
+		return false;
+	}
+	task();
+	mergeQueuedRefs();
+	return true;
+}
+
+// called before the current thread blocks waiting for another task; ensures that there is a worker
+// available to run queued tasks while it is blocked. Blocked threads do not run other tasks while
+// waiting, as the task they are waiting for may only be able to continue once they return
+void ThreadPool::beginBlocking()
+{
+	if (idle.load() == 0)
+	{
+		startWorker();
+	}
+}
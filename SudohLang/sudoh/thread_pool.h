@@ -0,0 +1,54 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+typedef std::function<void()> PoolTask;
+
+// pool of worker threads which run the tasks of parallel Sudoh code. Each thread has its own queue
+// of tasks: tasks submitted by a thread are run by it most recently submitted first, and a thread
+// without any tasks steals the least recently submitted tasks of other threads. Threads which are
+// not workers (e.g. the main thread) share a single queue. The number of threads, including the
+// thread waiting for the parallel work to finish, is set by SUDOH_THREADS. A thread which has to
+// block (e.g. on a channel) while there are no idle workers starts a spare worker, so that queued
+// tasks can still be run
+class ThreadPool
+{
+	struct TaskQueue
+	{
+		std::mutex lock;
+		std::deque<PoolTask> tasks;
+	};
+
+	// queues of all threads that may be started; only the first numQueues are in use
+	std::vector<std::unique_ptr<TaskQueue>> queues;
+	std::atomic<size_t> numQueues;
+	size_t numThreads;
+
+	// number of tasks in all queues; idle workers sleep until it is nonzero
+	std::atomic<size_t> queued;
+	std::atomic<size_t> idle;
+	std::mutex sleepLock;
+	std::condition_variable wake;
+
+	ThreadPool();
+	void startWorker();
+	void runWorker(size_t index);
+	bool takeTask(PoolTask& task);
+
+public:
+	static ThreadPool& instance();
+
+	size_t size() const;
+	void submit(PoolTask task);
+	bool runPendingTask();
+	void beginBlocking();
+};
+
+#endif
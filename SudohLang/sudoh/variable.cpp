@@ -1,10 +1,15 @@
 #include "variable.h"
+#include "object.h"
+#include "heap.h"
 #include "runtime_ex.h"
+#include "simd.h"
+#include "file_io.h"
 #include <string>
 #include <sstream>
 #include <iostream>
 #include <memory>
 #include <cmath>
+#include <charconv>
 
 // epsilon used for checking if a number (inherently type double) can be said to be an integer
 constexpr double EPSILON = 0.0001;
@@ -16,9 +21,9 @@ constexpr double EPSILON = 0.0001;
 
 bool Variable::stringCheck(const Variable& var, const std::string*& out)
 {
-	if (var.type == Type::string)
+	if (var.isString())
 	{
-		out = &var.val.stringVal;
+		out = &var.str();
 		return true;
 	}
 	return false;
@@ -29,7 +34,7 @@ bool Variable::indexCheck(const Variable& var, size_t& out)
 	if (var.type == Type::number)
 	{
 		double rounded = round(var.val.numVal);
-		if (rounded >= 0.0 && rounded < SIZE_MAX && abs(rounded - var.val.numVal) < EPSILON)
+		if (rounded >= 0.0 && rounded < SIZE_MAX && std::abs(rounded - var.val.numVal) < EPSILON)
 		{
 			out = (size_t)rounded;
 			return true;
@@ -58,6 +63,96 @@ bool Variable::listCheck(const Variable& var, List*& out)
 	return false;
 }
 
+bool Variable::objectCheck(const Variable& var, Object*& out)
+{
+	if (var.type == Type::object)
+	{
+		out = var.val.objRef.get();
+		return true;
+	}
+	return false;
+}
+
+bool Variable::boolCheck(const Variable& var, bool& out)
+{
+	if (var.type == Type::boolean)
+	{
+		out = var.val.boolVal;
+		return true;
+	}
+	return false;
+}
+
+// copies the elements of a list which holds only numbers into a contiguous array
+bool Variable::numListCheck(const Variable& var, std::vector<double>& out)
+{
+	if (var.type != Type::list)
+	{
+		return false;
+	}
+	const List& list = *var.val.listRef;
+	out.resize(list.size());
+	for (size_t i = 0; i < list.size(); i++)
+	{
+		if (list[i].type != Type::number)
+		{
+			return false;
+		}
+		out[i] = list[i].val.numVal;
+	}
+	return true;
+}
+
+bool Variable::taskCheck(const Variable& var, Task*& out)
+{
+	if (var.type == Type::task)
+	{
+		out = var.val.taskRef.get();
+		return true;
+	}
+	return false;
+}
+
+bool Variable::channelCheck(const Variable& var, Channel*& out)
+{
+	if (var.type == Type::channel)
+	{
+		out = var.val.channelRef.get();
+		return true;
+	}
+	return false;
+}
+
+bool Variable::matrixCheck(const Variable& var, Matrix*& out)
+{
+	if (var.type == Type::matrix)
+	{
+		out = var.val.matrixRef.get();
+		return true;
+	}
+	return false;
+}
+
+bool Variable::bytesCheck(const Variable& var, Bytes*& out)
+{
+	if (var.type == Type::bytes)
+	{
+		out = var.val.bytesRef.get();
+		return true;
+	}
+	return false;
+}
+
+bool Variable::heapCheck(const Variable& var, Heap*& out)
+{
+	if (var.type == Type::heap)
+	{
+		out = var.val.heapRef.get();
+		return true;
+	}
+	return false;
+}
+
 size_t assertValidIndex(const std::string& containerType, const Variable& index)
 {
 	size_t idx;
@@ -73,6 +168,31 @@ size_t assertValidIndex(const std::string& containerType, const Variable& index)
 // |   Variable implementation   |
 // +-----------------------------+
 
+// strings of each single character, which the text of a charRef variable refers to; never freed, so that
+// they remain valid while static objects are destroyed at exit
+static const std::string* characterStrings()
+{
+	static const std::string* strings = [] {
+		std::string* s = new std::string[256];
+		for (int c = 0; c < 256; c++)
+		{
+			s[c] = std::string(1, (char)c);
+		}
+		return s;
+	}();
+	return strings;
+}
+
+// returns the text of a string or character variable
+const std::string& Variable::str() const
+{
+	if (type == Type::charRef)
+	{
+		return characterStrings()[(unsigned char)val.charVal];
+	}
+	return val.stringRef->str();
+}
+
 std::string Variable::typeString() const
 {
 	switch (type)
@@ -82,11 +202,24 @@ std::string Variable::typeString() const
 	case Type::boolean:
 		return "boolean";
 	case Type::string:
+	case Type::charRef:
 		return "string";
 	case Type::list:
 		return "list";
 	case Type::object:
 		return "object";
+	case Type::task:
+		return "task";
+	case Type::channel:
+		return "channel";
+	case Type::matrix:
+		return "matrix";
+	case Type::lines:
+		return "lines";
+	case Type::bytes:
+		return "bytes";
+	case Type::heap:
+		return "heap";
 	default:
 		return "null";
 	}
@@ -95,29 +228,59 @@ std::string Variable::typeString() const
 Variable::Val::Val() : boolVal(false) {}
 Variable::Val::Val(bool val) : boolVal(val) {}
 Variable::Val::Val(double val) : numVal(val) {}
-Variable::Val::Val(std::string val) : stringVal(val) {}
-Variable::Val::Val(std::shared_ptr<List> val) : listRef(val) {}
-Variable::Val::Val(std::shared_ptr<Object> val) : objRef(val) {}
+Variable::Val::Val(std::string val) : stringRef(StringRef::make(std::move(val))) {}
+Variable::Val::Val(StringRef val) : stringRef(std::move(val)) {}
+Variable::Val::Val(ListRef val) : listRef(val) {}
+Variable::Val::Val(ObjectRef val) : objRef(val) {}
+Variable::Val::Val(std::shared_ptr<Task> val) : taskRef(val) {}
+Variable::Val::Val(std::shared_ptr<Channel> val) : channelRef(val) {}
+Variable::Val::Val(MatrixRef val) : matrixRef(val) {}
+Variable::Val::Val(std::shared_ptr<FileLines> val) : linesRef(val) {}
+Variable::Val::Val(BytesRef val) : bytesRef(val) {}
+Variable::Val::Val(HeapRef val) : heapRef(val) {}
 Variable::Val::~Val() {}
 
 Variable::Variable() : type(Type::null) {}
 Variable::Variable(double n) : type(Type::number), val(n) {}
 Variable::Variable(int n) : type(Type::number), val((double)n) {}
 Variable::Variable(bool b) : type(Type::boolean), val(b) {}
-Variable::Variable(std::string s) : type(Type::string), val(s) {}
-Variable::Variable(std::shared_ptr<List> l) : type(Type::list), val(l) {}
-Variable::Variable(std::shared_ptr<Object> m) : type(Type::object), val(m)
+Variable::Variable(std::string s) : type(Type::string), val(std::move(s)) {}
+Variable::Variable(StringRef s) : type(Type::string), val(std::move(s)) {}
+
+// returns a variable holding a single character, which needs no memory other than the variable itself
+Variable Variable::character(char c)
+{
+	Variable var;
+	var.type = Type::charRef;
+	var.val.charVal = c;
+	return var;
+}
+Variable::Variable(ListRef l) : type(Type::list), val(l) {}
+Variable::Variable(ObjectRef m) : type(Type::object), val(m)
 {
-	for (auto& kv : *m)
+	// the keys of an object with a shape are string literals
+	if (m->shaped())
+	{
+		return;
+	}
+	for (const auto& kv : *m)
 	{
-		if (kv.first.type != Type::string)
+		if (!kv.first.isString())
 		{
 			runtimeException("object field identifier must be a string; got type '" + kv.first.typeString() + "'");
 		}
 	}
 }
 
+Variable::Variable(std::shared_ptr<Task> t) : type(Type::task), val(t) {}
+Variable::Variable(std::shared_ptr<Channel> c) : type(Type::channel), val(c) {}
+Variable::Variable(MatrixRef m) : type(Type::matrix), val(m) {}
+Variable::Variable(std::shared_ptr<FileLines> l) : type(Type::lines), val(l) {}
+Variable::Variable(BytesRef b) : type(Type::bytes), val(b) {}
+Variable::Variable(HeapRef h) : type(Type::heap), val(h) {}
+
 Variable::Variable(const Variable& other) : type(other.type) { setValue(other); }
+Variable::Variable(Variable&& other) noexcept : type(other.type) { moveValue(other); }
 
 Variable::~Variable() { freeMem(); }
 
@@ -132,16 +295,84 @@ void Variable::setValue(const Variable& other)
 	case Type::boolean:
 		val.boolVal = other.val.boolVal;
 		break;
+	case Type::charRef:
+		val.charVal = other.val.charVal;
+		break;
+	case Type::string:
+		new(&val.stringRef) StringRef(other.val.stringRef);
+		break;
+	case Type::list:
+		new(&val.listRef) ListRef(other.val.listRef);
+		break;
+	case Type::object:
+		new(&val.objRef) ObjectRef(other.val.objRef);
+		break;
+	case Type::task:
+		new(&val.taskRef) std::shared_ptr<Task>(other.val.taskRef);
+		break;
+	case Type::channel:
+		new(&val.channelRef) std::shared_ptr<Channel>(other.val.channelRef);
+		break;
+	case Type::matrix:
+		new(&val.matrixRef) MatrixRef(other.val.matrixRef);
+		break;
+	case Type::lines:
+		new(&val.linesRef) std::shared_ptr<FileLines>(other.val.linesRef);
+		break;
+	case Type::bytes:
+		new(&val.bytesRef) BytesRef(other.val.bytesRef);
+		break;
+	case Type::heap:
+		new(&val.heapRef) HeapRef(other.val.heapRef);
+		break;
+	}
+}
+
+// helper function for move constructor/assignment operator to take value from other Variable, which
+// is left null; lists and objects are transferred without changing their reference counts
+void Variable::moveValue(Variable& other)
+{
+	switch (other.type)
+	{
+	case Type::number:
+		val.numVal = other.val.numVal;
+		break;
+	case Type::boolean:
+		val.boolVal = other.val.boolVal;
+		break;
+	case Type::charRef:
+		val.charVal = other.val.charVal;
+		break;
 	case Type::string:
-		new(&val.stringVal) std::string(other.val.stringVal);
+		new(&val.stringRef) StringRef(std::move(other.val.stringRef));
 		break;
 	case Type::list:
-		new(&val.listRef) std::shared_ptr<List>(other.val.listRef);
+		new(&val.listRef) ListRef(std::move(other.val.listRef));
 		break;
 	case Type::object:
-		new(&val.listRef) std::shared_ptr<Object>(other.val.objRef);
+		new(&val.objRef) ObjectRef(std::move(other.val.objRef));
+		break;
+	case Type::task:
+		new(&val.taskRef) std::shared_ptr<Task>(std::move(other.val.taskRef));
+		break;
+	case Type::channel:
+		new(&val.channelRef) std::shared_ptr<Channel>(std::move(other.val.channelRef));
+		break;
+	case Type::matrix:
+		new(&val.matrixRef) MatrixRef(std::move(other.val.matrixRef));
+		break;
+	case Type::lines:
+		new(&val.linesRef) std::shared_ptr<FileLines>(std::move(other.val.linesRef));
+		break;
+	case Type::bytes:
+		new(&val.bytesRef) BytesRef(std::move(other.val.bytesRef));
+		break;
+	case Type::heap:
+		new(&val.heapRef) HeapRef(std::move(other.val.heapRef));
 		break;
 	}
+	other.freeMem();
+	other.type = Type::null;
 }
 
 // helper function for freeing any allocated memory if needed; used by
@@ -150,15 +381,39 @@ void Variable::freeMem()
 {
 	if (type == Type::list)
 	{
-		val.listRef.~shared_ptr();
+		val.listRef.~ListRef();
 	}
 	else if (type == Type::object)
 	{
-		val.objRef.~shared_ptr();
+		val.objRef.~ObjectRef();
 	}
 	else if (type == Type::string)
 	{
-		val.stringVal.~basic_string();
+		val.stringRef.~StringRef();
+	}
+	else if (type == Type::task)
+	{
+		val.taskRef.~shared_ptr();
+	}
+	else if (type == Type::channel)
+	{
+		val.channelRef.~shared_ptr();
+	}
+	else if (type == Type::matrix)
+	{
+		val.matrixRef.~MatrixRef();
+	}
+	else if (type == Type::lines)
+	{
+		val.linesRef.~shared_ptr();
+	}
+	else if (type == Type::bytes)
+	{
+		val.bytesRef.~BytesRef();
+	}
+	else if (type == Type::heap)
+	{
+		val.heapRef.~HeapRef();
 	}
 }
 
@@ -168,19 +423,25 @@ std::string Variable::toString() const
 	{
 	case Type::number:
 	{
-		std::stringstream s;
+		// integers are printed without a fractional part, and other numbers in the shortest form that reads
+		// back as the same number e.g. 2.5
 		double d = val.numVal;
-		if (abs(round(d) - d) < EPSILON)
+		if (std::abs(round(d) - d) < EPSILON)
 		{
+			std::stringstream s;
 			s.precision(0);
+			s << std::fixed << d;
+			return s.str();
 		}
-		s << std::fixed << d;
-		return s.str();
+		char digits[32];
+		return std::string(digits, std::to_chars(digits, digits + sizeof(digits), d).ptr);
 	}
 	case Type::boolean:
 		return val.boolVal ? "true" : "false";
 	case Type::string:
-		return val.stringVal;
+		return val.stringRef->str();
+	case Type::charRef:
+		return std::string(1, val.charVal);
 	case Type::list:
 	{
 		std::string contents = "[ ";
@@ -201,27 +462,148 @@ std::string Variable::toString() const
 	{
 		std::string contents = "{ ";
 		bool first = true;
-		for (auto& e : *val.objRef)
+		for (const auto& e : *val.objRef)
 		{
 			if (!first)
 			{
 				contents += ", ";
 			}
-			contents += e.first.val.stringVal + " <- " + e.second.toString();
+			contents += e.first.str() + " <- " + e.second.toString();
 			first = false;
 		}
 		contents += " }";
 		return contents;
 	}
+	case Type::task:
+		return "task";
+	case Type::channel:
+		return "channel";
+	case Type::matrix:
+	{
+		const Matrix& m = *val.matrixRef;
+		std::string contents = "[ ";
+		for (size_t r = 0; r < m.rows; r++)
+		{
+			contents += r == 0 ? "[ " : ", [ ";
+			for (size_t c = 0; c < m.cols; c++)
+			{
+				contents += (c == 0 ? "" : ", ") + Variable(m.at(r, c)).toString();
+			}
+			contents += " ]";
+		}
+		contents += " ]";
+		return contents;
+	}
+	case Type::lines:
+		return "lines";
+	case Type::heap:
+		return "heap";
+	case Type::bytes:
+	{
+		// bytes are shown as a list of their values
+		std::string contents = "[ ";
+		bool first = true;
+		for (uint8_t b : *val.bytesRef)
+		{
+			if (!first)
+			{
+				contents += ", ";
+			}
+			contents += std::to_string(b);
+			first = false;
+		}
+		contents += " ]";
+		return contents;
+	}
 	default:
 		return "null";
 	}
 }
 
+// +--------------------------------------------------------+
+// |   Hashing and equality for using variables as keys,     |
+// |   e.g. for memoization. Numbers, strings, and booleans  |
+// |   are compared by value, other types by reference       |
+// +--------------------------------------------------------+
+
+double maybeIntVal(double val);
+
+size_t Variable::keyHash() const
+{
+	switch (type)
+	{
+	case Type::number:
+		return std::hash<double>()(maybeIntVal(val.numVal));
+	case Type::boolean:
+		return std::hash<bool>()(val.boolVal);
+	case Type::string:
+	case Type::charRef:
+		return std::hash<std::string>()(str());
+	case Type::list:
+		return std::hash<List*>()(val.listRef.get());
+	case Type::object:
+		return std::hash<Object*>()(val.objRef.get());
+	case Type::task:
+		return std::hash<Task*>()(val.taskRef.get());
+	case Type::channel:
+		return std::hash<Channel*>()(val.channelRef.get());
+	case Type::matrix:
+		return std::hash<Matrix*>()(val.matrixRef.get());
+	case Type::lines:
+		return std::hash<FileLines*>()(val.linesRef.get());
+	case Type::bytes:
+		return std::hash<Bytes*>()(val.bytesRef.get());
+	case Type::heap:
+		return std::hash<Heap*>()(val.heapRef.get());
+	default:
+		return 0;
+	}
+}
+
+bool Variable::keyEquals(const Variable& other) const
+{
+	if (isString() && other.isString())
+	{
+		return str() == other.str();
+	}
+	if (type != other.type)
+	{
+		return false;
+	}
+
+	switch (type)
+	{
+	case Type::number:
+		return maybeIntVal(val.numVal) == maybeIntVal(other.val.numVal);
+	case Type::boolean:
+		return val.boolVal == other.val.boolVal;
+	case Type::list:
+		return val.listRef == other.val.listRef;
+	case Type::object:
+		return val.objRef == other.val.objRef;
+	case Type::task:
+		return val.taskRef == other.val.taskRef;
+	case Type::channel:
+		return val.channelRef == other.val.channelRef;
+	case Type::matrix:
+		return val.matrixRef == other.val.matrixRef;
+	case Type::lines:
+		return val.linesRef == other.val.linesRef;
+	case Type::bytes:
+		return val.bytesRef == other.val.bytesRef;
+	case Type::heap:
+		return val.heapRef == other.val.heapRef;
+	default:
+		return true;
+	}
+}
+
 // +------------------------------------------------------------+
 // |   Binary arithmetic operators; all arithmetic operators    |
 // |   except '+' only valid between 2 numbers ('+' also used   |
-// |   for string concatenation                                 |
+// |   for string concatenation). Matrices of the same size     |
+// |   may be added and subtracted elementwise, and multiplied  |
+// |   or divided by a number                                   |
 // +------------------------------------------------------------+
 
 Variable Variable::operator+(const Variable& other) const
@@ -231,27 +613,120 @@ Variable Variable::operator+(const Variable& other) const
 	case Type::number:
 		if (other.type == Type::string)
 		{
-			return toString() + other.val.stringVal;
+			return Rope::concat(toString(), other.val.stringRef);
+		}
+		if (other.type == Type::charRef)
+		{
+			return toString() + other.val.charVal;
 		}
 		if (other.type == Type::number)
 		{
 			return val.numVal + other.val.numVal;
 		}
 		break;
+	case Type::charRef:
+		// a character is concatenated as a string of one character
+		if (other.type == Type::string)
+		{
+			return Rope::concat(toString(), other.val.stringRef);
+		}
+		return val.charVal + other.toString();
 	case Type::string:
-		return val.stringVal + other.toString();
+		if (other.type == Type::string)
+		{
+			return Rope::concat(val.stringRef, other.val.stringRef);
+		}
+		return Rope::concat(val.stringRef, other.toString());
+	case Type::matrix:
+		if (other.type == Type::matrix)
+		{
+			val.matrixRef->assertSameSize(*other.val.matrixRef, "+");
+			return MatrixRef(val.matrixRef->combined(*other.val.matrixRef, simdAdd));
+		}
+		break;
 	}
 
 	runtimeException("illegal operation '+' between types " + typeString() + " and " + other.typeString());
 	return Variable();
 }
 
+// concatenates a chain of '+' such as 'a + ", " + b' with one allocation, rather than one for each '+'.
+// Operands are added one at a time until the result is a string (so that numbers at the beginning of a chain
+// are summed, as from left to right); the text of the rest is then copied into one string reserved for all
+// of it. Strings long enough to be ropes are joined as ropes rather than copied, as by 'operator+'
+Variable Variable::concat(std::initializer_list<const Variable*> operands)
+{
+	auto it = operands.begin();
+	Variable result = **it++;
+	while (it != operands.end() && !result.isString())
+	{
+		result = result + **it++;
+	}
+	if (it == operands.end())
+	{
+		return result;
+	}
+
+	auto isLong = [](const Variable& var)
+	{
+		return var.type == Type::string && var.val.stringRef->length() >= MIN_ROPE_LENGTH;
+	};
+	size_t length = 0;
+	for (auto rest = it; rest != operands.end(); rest++)
+	{
+		// other types than strings are reckoned as a number of a few digits
+		length += (*rest)->isString() ? (isLong(**rest) ? 0 : (*rest)->str().length()) : 8;
+	}
+
+	// text before that being copied, if the result or an operand is long
+	StringRef head;
+	std::string text;
+	if (isLong(result))
+	{
+		head = result.val.stringRef;
+		text.reserve(length);
+	}
+	else
+	{
+		text.reserve(result.str().length() + length);
+		text += result.str();
+	}
+	for (; it != operands.end(); it++)
+	{
+		const Variable& var = **it;
+		if (isLong(var))
+		{
+			head = head.get() ? Rope::concat(Rope::concat(head, text), var.val.stringRef) :
+				Rope::concat(text, var.val.stringRef);
+			text.clear();
+		}
+		else if (var.isString())
+		{
+			text += var.str();
+		}
+		else
+		{
+			text += var.toString();
+		}
+	}
+	if (!head.get())
+	{
+		return text;
+	}
+	return text.empty() ? head : Rope::concat(head, std::move(text));
+}
+
 Variable Variable::operator-(const Variable& other) const
 {
 	if (type == Type::number && other.type == Type::number)
 	{
 		return val.numVal - other.val.numVal;
 	}
+	if (type == Type::matrix && other.type == Type::matrix)
+	{
+		val.matrixRef->assertSameSize(*other.val.matrixRef, "-");
+		return MatrixRef(val.matrixRef->combined(*other.val.matrixRef, simdSubtract));
+	}
 
 	runtimeException("illegal operation '-' between types " + typeString() + " and " + other.typeString());
 	return Variable();
@@ -263,6 +738,14 @@ Variable Variable::operator*(const Variable& other) const
 	{
 		return val.numVal * other.val.numVal;
 	}
+	if (type == Type::matrix && other.type == Type::number)
+	{
+		return MatrixRef(val.matrixRef->scaled(other.val.numVal));
+	}
+	if (type == Type::number && other.type == Type::matrix)
+	{
+		return MatrixRef(other.val.matrixRef->scaled(val.numVal));
+	}
 
 	runtimeException("illegal operation '*' between types " + typeString() + " and " + other.typeString());
 	return Variable();
@@ -274,6 +757,10 @@ Variable Variable::operator/(const Variable& other) const
 	{
 		return val.numVal / other.val.numVal;
 	}
+	if (type == Type::matrix && other.type == Type::number)
+	{
+		return MatrixRef(val.matrixRef->divided(other.val.numVal));
+	}
 
 	runtimeException("illegal operation '/' between types " + typeString() + " and " + other.typeString());
 	return Variable();
@@ -293,7 +780,9 @@ Variable Variable::operator%(const Variable& other) const
 // +--------------------------------------------------------------+
 // |   Compound assignment operators; there is no direct          |
 // |   syntax for accomplishing these in Sudoh, but something     |
-// |   like 'a <- a + 1' will be translated to use '+=' for 'a'   |
+// |   like 'a <- a + 1' will be translated to use '+=' for 'a'.  |
+// |   Matrices are assigned a new matrix rather than modified,   |
+// |   as other variables may refer to the same matrix            |
 // +--------------------------------------------------------------+
 
 void Variable::operator+=(const Variable& other)
@@ -302,9 +791,25 @@ void Variable::operator+=(const Variable& other)
 	{
 		val.numVal += other.val.numVal;
 	}
-	else if (type == Type::string && other.type == Type::string)
+	else if (type == Type::string)
+	{
+		// a string which is not shared with other variables is appended to in place
+		if (val.stringRef.unique() && val.stringRef->isFlat())
+		{
+			val.stringRef->append(other.isString() ? other.str() : other.toString());
+		}
+		else
+		{
+			*this = *this + other;
+		}
+	}
+	else if (type == Type::charRef)
 	{
-		val.stringVal += other.val.stringVal;
+		*this = *this + other;
+	}
+	else if (type == Type::matrix)
+	{
+		*this = *this + other;
 	}
 	else
 	{
@@ -318,6 +823,10 @@ void Variable::operator-=(const Variable& other)
 	{
 		val.numVal -= other.val.numVal;
 	}
+	else if (type == Type::matrix)
+	{
+		*this = *this - other;
+	}
 	else
 	{
 		runtimeException("illegal compound subtraction assignment between types " + typeString() + " and " + other.typeString());
@@ -330,6 +839,10 @@ void Variable::operator*=(const Variable& other)
 	{
 		val.numVal *= other.val.numVal;
 	}
+	else if (type == Type::matrix)
+	{
+		*this = *this * other;
+	}
 	else
 	{
 		runtimeException("illegal compound multiplication assignment between types " + typeString() + " and " + other.typeString());
@@ -342,6 +855,10 @@ void Variable::operator/=(const Variable& other)
 	{
 		val.numVal /= other.val.numVal;
 	}
+	else if (type == Type::matrix)
+	{
+		*this = *this / other;
+	}
 	else
 	{
 		runtimeException("illegal compound division assignment between types " + typeString() + " and " + other.typeString());
@@ -371,6 +888,17 @@ Variable& Variable::operator=(const Variable& other)
 	return *this;
 }
 
+Variable& Variable::operator=(Variable&& other) noexcept
+{
+	if (this != &other)
+	{
+		freeMem();
+		type = other.type;
+		moveValue(other);
+	}
+	return *this;
+}
+
 // +-----------------------------------------------------------+
 // |   Comparison operators; all Sudoh comparison ops except   |
 // |   for '=' and '!=' are only valid between values of the   |
@@ -380,7 +908,7 @@ Variable& Variable::operator=(const Variable& other)
 double maybeIntVal(double val)
 {
 	double rounded = round(val);
-	return abs(rounded - val) < EPSILON ? rounded : val;
+	return std::abs(rounded - val) < EPSILON ? rounded : val;
 }
 
 bool Variable::operator==(const Variable& other) const
@@ -389,6 +917,15 @@ bool Variable::operator==(const Variable& other) const
 	{
 		return type == other.type;
 	}
+	if (isString() && other.isString())
+	{
+		if (type == Type::charRef && other.type == Type::charRef)
+		{
+			return val.charVal == other.val.charVal;
+		}
+		return (type == Type::string && other.type == Type::string && val.stringRef == other.val.stringRef) ||
+			str() == other.str();
+	}
 
 	if (other.type != type) // TODO maybe make valid between different types; just return false
 	{
@@ -401,12 +938,22 @@ bool Variable::operator==(const Variable& other) const
 		return maybeIntVal(val.numVal) == maybeIntVal(other.val.numVal);
 	case Type::boolean:
 		return val.boolVal == other.val.boolVal;
-	case Type::string:
-		return val.stringVal == other.val.stringVal;
 	case Type::list:
 		return val.listRef == other.val.listRef;
 	case Type::object:
 		return val.objRef == other.val.objRef;
+	case Type::task:
+		return val.taskRef == other.val.taskRef;
+	case Type::channel:
+		return val.channelRef == other.val.channelRef;
+	case Type::matrix:
+		return val.matrixRef == other.val.matrixRef;
+	case Type::lines:
+		return val.linesRef == other.val.linesRef;
+	case Type::bytes:
+		return val.bytesRef == other.val.bytesRef;
+	case Type::heap:
+		return val.heapRef == other.val.heapRef;
 	}
 	return false;
 }
@@ -418,6 +965,10 @@ bool Variable::operator!=(const Variable& other) const
 
 bool Variable::operator<(const Variable& other) const
 {
+	if (isString() && other.isString())
+	{
+		return str() < other.str();
+	}
 	if (other.type != type)
 	{
 		runtimeException("illegal comparison between types " + typeString() + " and " + other.typeString());
@@ -427,8 +978,6 @@ bool Variable::operator<(const Variable& other) const
 	{
 	case Type::number:
 		return maybeIntVal(val.numVal) < maybeIntVal(other.val.numVal);
-	case Type::string:
-		return val.stringVal < other.val.stringVal;
 	}
 
 	runtimeException("illegal comparison between types " + typeString() + " and " + other.typeString());
@@ -437,6 +986,10 @@ bool Variable::operator<(const Variable& other) const
 
 bool Variable::operator<=(const Variable& other) const
 {
+	if (isString() && other.isString())
+	{
+		return str() <= other.str();
+	}
 	if (other.type != type)
 	{
 		runtimeException("illegal comparison between types " + typeString() + " and " + other.typeString());
@@ -446,8 +999,6 @@ bool Variable::operator<=(const Variable& other) const
 	{
 	case Type::number:
 		return maybeIntVal(val.numVal) <= maybeIntVal(other.val.numVal);
-	case Type::string:
-		return val.stringVal <= other.val.stringVal;
 	}
 
 	runtimeException("illegal comparison between types " + typeString() + " and " + other.typeString());
@@ -476,6 +1027,7 @@ Variable& Variable::operator[](const Variable& index)
 	switch (type)
 	{
 	case Type::string:
+	case Type::charRef:
 		runtimeException("illegal attempt to modify string");
 	case Type::list:
 	{
@@ -492,11 +1044,15 @@ Variable& Variable::operator[](const Variable& index)
 		return list[idx];
 	}
 	case Type::object:
-		if (index.type != Type::string)
+		if (!index.isString())
 		{
 			runtimeException("index into object must be of type 'string'");
 		}
 		return (*val.objRef)[index];
+	case Type::matrix:
+		runtimeException("an element of a matrix must be assigned to with both its row and column e.g. 'm[1][2] <- 3'");
+	case Type::bytes:
+		runtimeException("cannot refer to a byte of bytes other than by assigning to it e.g. 'b[1] <- 3'");
 	}
 
 	runtimeException("cannot index into type " + typeString());
@@ -510,13 +1066,19 @@ Variable Variable::at(const Variable& index) const
 	case Type::string:
 	{
 		size_t idx = assertValidIndex("string", index);
-		if (idx >= val.stringVal.length())
+		if (idx >= val.stringRef->length())
 		{
 			runtimeException("specified index '" + std::to_string(idx) + "' out of bounds of string (length " +
-				std::to_string(val.stringVal.length()) + ")");
+				std::to_string(val.stringRef->length()) + ")");
 		}
-		return std::string(1, val.stringVal[idx]);
+		return character(val.stringRef->str()[idx]);
 	}
+	case Type::charRef:
+		if (assertValidIndex("string", index) != 0)
+		{
+			runtimeException("specified index '" + index.toString() + "' out of bounds of string (length 1)");
+		}
+		return *this;
 	case Type::list:
 	{
 		size_t idx = assertValidIndex("list", index);
@@ -530,17 +1092,41 @@ Variable Variable::at(const Variable& index) const
 	case Type::object:
 	{
 		Object& o = *val.objRef;
-		if (index.type != Type::string)
+		if (!index.isString())
 		{
 			runtimeException("index into object must be of type 'string'");
 		}
 
-		auto item = o.find(index);
-		if (item == o.end())
+		Variable* item = o.find(index);
+		if (!item)
+		{
+			runtimeException("field '" + index.str() + "' does not exist in the object");
+		}
+		return *item;
+	}
+	case Type::matrix:
+	{
+		// a single index into a matrix outputs a copy of a row as a list
+		const Matrix& m = *val.matrixRef;
+		size_t row = assertValidIndex("matrix", index);
+		m.assertIndex(row, 0);
+		List list;
+		list.reserve(m.cols);
+		for (size_t c = 0; c < m.cols; c++)
+		{
+			list.emplace_back(m.at(row, c));
+		}
+		return ListRef(std::move(list));
+	}
+	case Type::bytes:
+	{
+		size_t idx = assertValidIndex("bytes", index);
+		if (idx >= val.bytesRef->size())
 		{
-			runtimeException("field '" + index.val.stringVal + "' does not exist in the object");
+			runtimeException("specified index '" + std::to_string(idx) + "' out of bounds of bytes (length " +
+				std::to_string(val.bytesRef->size()) + ")");
 		}
-		return item->second;
+		return (double)(*val.bytesRef)[idx];
 	}
 	}
 	
@@ -548,6 +1134,185 @@ Variable Variable::at(const Variable& index) const
 	return Variable();
 }
 
+// indexing on the left side of an assignment, which refers to a byte of bytes directly or otherwise
+// to an element of a container
+// indexing by a string literal e.g. 'node["next"]', which finds a field of an object with a shape by the
+// slot cached by the FieldKey
+Variable& Variable::operator[](const FieldKey& field)
+{
+	if (type == Type::object)
+	{
+		return (*val.objRef)[field];
+	}
+	return (*this)[field.key];
+}
+
+Variable Variable::at(const FieldKey& field) const
+{
+	if (type == Type::object)
+	{
+		Variable* item = val.objRef->find(field);
+		if (!item)
+		{
+			runtimeException("field '" + field.key.str() + "' does not exist in the object");
+		}
+		return *item;
+	}
+	return at(field.key);
+}
+
+Variable::ElementRef Variable::element(const Variable& index)
+{
+	return ElementRef(*this, index);
+}
+
+// indexing by two values at once e.g. 'm[i][j]', which accesses an element of a matrix directly or
+// otherwise indexes twice
+Variable::ElementRef Variable::element(const Variable& row, const Variable& col)
+{
+	return ElementRef(*this, row, col);
+}
+
+Variable Variable::at(const Variable& row, const Variable& col) const
+{
+	if (type == Type::matrix)
+	{
+		const Matrix& m = *val.matrixRef;
+		return m.data[m.assertIndex(assertValidIndex("matrix", row), assertValidIndex("matrix", col))];
+	}
+	return at(row).at(col);
+}
+
+Variable::ElementRef::ElementRef(Variable& container, const Variable& index) : var(nullptr), num(nullptr), byte(nullptr)
+{
+	if (container.type == Type::bytes)
+	{
+		Bytes& bytes = *container.val.bytesRef;
+		size_t idx = assertValidIndex("bytes", index);
+		if (idx >= bytes.size())
+		{
+			runtimeException("specified index '" + std::to_string(idx) + "' out of bounds of bytes (length " +
+				std::to_string(bytes.size()) + ")");
+		}
+		byte = &bytes[idx];
+	}
+	else
+	{
+		var = &container[index];
+	}
+}
+
+Variable::ElementRef::ElementRef(Variable& container, const Variable& row, const Variable& col) : var(nullptr), num(nullptr), byte(nullptr)
+{
+	if (container.type == Type::matrix)
+	{
+		Matrix& m = *container.val.matrixRef;
+		num = &m.data[m.assertIndex(assertValidIndex("matrix", row), assertValidIndex("matrix", col))];
+	}
+	else
+	{
+		*this = ElementRef(container[row], col);
+	}
+}
+
+// returns the value of a byte or an element of a matrix
+Variable Variable::ElementRef::get() const
+{
+	return num ? *num : (double)*byte;
+}
+
+// assigns to a byte or an element of a matrix, which may only hold numbers (integers in [0, 255] for bytes)
+void Variable::ElementRef::assign(const Variable& value)
+{
+	if (num)
+	{
+		if (value.type != Type::number)
+		{
+			runtimeException("cannot assign value of type " + value.typeString() + " to an element of a matrix");
+		}
+		*num = value.val.numVal;
+		return;
+	}
+	size_t b = 0;
+	if (!indexCheck(value, b) || b > UINT8_MAX)
+	{
+		runtimeException("cannot assign " + value.toString() + " to a byte, which must be an integer in the range [0, 255]");
+	}
+	*byte = (uint8_t)b;
+}
+
+void Variable::ElementRef::operator=(const Variable& value)
+{
+	if (var)
+	{
+		*var = value;
+	}
+	else
+	{
+		assign(value);
+	}
+}
+
+void Variable::ElementRef::operator+=(const Variable& other)
+{
+	if (var)
+	{
+		*var += other;
+	}
+	else
+	{
+		assign(get() + other);
+	}
+}
+
+void Variable::ElementRef::operator-=(const Variable& other)
+{
+	if (var)
+	{
+		*var -= other;
+	}
+	else
+	{
+		assign(get() - other);
+	}
+}
+
+void Variable::ElementRef::operator*=(const Variable& other)
+{
+	if (var)
+	{
+		*var *= other;
+	}
+	else
+	{
+		assign(get() * other);
+	}
+}
+
+void Variable::ElementRef::operator/=(const Variable& other)
+{
+	if (var)
+	{
+		*var /= other;
+	}
+	else
+	{
+		assign(get() / other);
+	}
+}
+
+void Variable::ElementRef::operator%=(const Variable& other)
+{
+	if (var)
+	{
+		*var %= other;
+	}
+	else
+	{
+		assign(get() % other);
+	}
+}
+
 // for converting a boolean variable to type bool for a condition
 Variable::operator bool() const
 {
@@ -568,13 +1333,40 @@ Variable::VariableIterator::VariableIterator(Variable* var, bool begin) : contai
 	switch (var->type)
 	{
 	case Type::string:
-		stringIt = begin ? var->val.stringVal.begin() : var->val.stringVal.end();
+	case Type::charRef:
+		stringIt = begin ? var->str().cbegin() : var->str().cend();
 		break;
 	case Type::list:
 		listIt = begin ? var->val.listRef->begin() : var->val.listRef->end();
 		break;
 	case Type::object:
-		objIt = begin ? var->val.objRef->begin() : var->val.objRef->end();
+		// the keys are copied, so that fields may be added or removed by the loop; the end is marked by an
+		// index past any object
+		copiedIndex = SIZE_MAX;
+		if (begin && var->val.objRef->size() != 0)
+		{
+			copied.reserve(var->val.objRef->size());
+			for (const auto& field : *var->val.objRef)
+			{
+				copied.push_back(field.first);
+			}
+			copiedIndex = 0;
+		}
+		break;
+	case Type::heap:
+		// the values are copied in order of priority, so that values may be pushed or popped by the loop
+		copiedIndex = SIZE_MAX;
+		if (begin && var->val.heapRef->size() != 0)
+		{
+			copied = var->val.heapRef->sorted();
+			copiedIndex = 0;
+		}
+		break;
+	case Type::lines:
+		lineIt = begin ? var->val.linesRef->file.begin() : var->val.linesRef->file.end();
+		break;
+	case Type::bytes:
+		bytesIt = begin ? var->val.bytesRef->begin() : var->val.bytesRef->end();
 		break;
 	default:
 		runtimeException("cannot iterate over type " + var->typeString());
@@ -586,34 +1378,53 @@ void Variable::VariableIterator::operator++()
 	switch (container->type)
 	{
 	case Type::string:
+	case Type::charRef:
 		stringIt++;
 		break;
 	case Type::list:
 		listIt++;
 		break;
 	case Type::object:
-		objIt++;
+	case Type::heap:
+		if (++copiedIndex == copied.size())
+		{
+			copiedIndex = SIZE_MAX;
+		}
+		break;
+	case Type::lines:
+		lineIt = FileLines::nextLine(lineIt, container->val.linesRef->file.end());
+		break;
+	case Type::bytes:
+		bytesIt++;
 		break;
 	}
 }
 
 Variable Variable::VariableIterator::operator*()
 {
-	if (container->type == Type::string)
+	if (container->isString())
 	{
-		return std::string(1, *stringIt);
+		return character(*stringIt);
 	}
 	if (container->type == Type::list)
 	{
 		return *listIt;
 	}
+	if (container->type == Type::lines)
+	{
+		return FileLines::lineAt(lineIt, container->val.linesRef->file.end());
+	}
+	if (container->type == Type::bytes)
+	{
+		return (double)*bytesIt;
+	}
 
-	return objIt->first;
+	return copied[copiedIndex];
 }
 
 bool Variable::VariableIterator::operator!=(const VariableIterator& other)
 {
-	if (container->type == Type::string)
+	if (container->isString())
 	{
 		return stringIt != other.stringIt;
 	}
@@ -621,8 +1432,16 @@ bool Variable::VariableIterator::operator!=(const VariableIterator& other)
 	{
 		return listIt != other.listIt;
 	}
+	if (container->type == Type::lines)
+	{
+		return lineIt != other.lineIt;
+	}
+	if (container->type == Type::bytes)
+	{
+		return bytesIt != other.bytesIt;
+	}
 
-	return objIt != other.objIt;
+	return copiedIndex != other.copiedIndex;
 }
 
 Variable::VariableIterator Variable::begin()
@@ -637,13 +1456,13 @@ Variable::VariableIterator Variable::end()
 
 bool Variable::ObjectComp::operator()(const Variable& left, const Variable& right) const
 {
-	if (left.type != Type::string)
+	if (!left.isString())
 	{
 		runtimeException("object field identifier must be a string; got type '" + left.typeString() + "'");
 	}
-	if (right.type != Type::string)
+	if (!right.isString())
 	{
 		runtimeException("object field identifier must be a string; got type '" + right.typeString() + "'");
 	}
-	return left.val.stringVal < right.val.stringVal;
+	return left.str() < right.str();
 }
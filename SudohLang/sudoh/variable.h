@@ -5,9 +5,20 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <cstdint>
+#include <initializer_list>
+#include "ref.h"
+#include "matrix.h"
+#include "rope.h"
 
 // enum that is used to keep track of the type of a variable
-enum class Type { number, boolean, string, list, object, null, charRef };
+enum class Type { number, boolean, string, list, object, null, charRef, task, channel, matrix, lines, bytes, heap };
+
+struct Task;
+struct Channel;
+struct FileLines;
+struct Heap;
+struct FieldKey;
 
 class Variable
 {
@@ -18,34 +29,63 @@ class Variable
 
 public:
 	typedef std::vector<Variable> List;
-	typedef std::map<Variable, Variable, ObjectComp> Object;
+	// defined in object.h
+	class Object;
+	typedef Ref<List> ListRef;
+	typedef Ref<Object> ObjectRef;
+	typedef Ref<Matrix> MatrixRef;
+	typedef Ref<Rope> StringRef;
+	typedef std::vector<uint8_t> Bytes;
+	typedef Ref<Bytes> BytesRef;
+	typedef Ref<Heap> HeapRef;
 
 private:
 	// standard library functions which have access to Variable members
 	friend Variable p_length(Variable var);
 	friend Variable p_remove(Variable list, Variable index);
 	friend Variable p_range(Variable indexable, Variable begin, Variable end);
+	friend class JSONWriter;
+	friend class SnapshotWriter;
 
 	Type type;
 	union Val
 	{
 		double numVal;
 		bool boolVal;
-		std::string stringVal;
-		std::shared_ptr<List> listRef;
-		std::shared_ptr<Object> objRef;
+		// a single character of a string, held by a charRef variable, which behaves as a string of that character
+		char charVal;
+		// strings are shared between copies of a variable until one is modified, so copying is cheap
+		StringRef stringRef;
+		ListRef listRef;
+		ObjectRef objRef;
+		std::shared_ptr<Task> taskRef;
+		std::shared_ptr<Channel> channelRef;
+		MatrixRef matrixRef;
+		std::shared_ptr<FileLines> linesRef;
+		BytesRef bytesRef;
+		HeapRef heapRef;
 
 		Val();
 		Val(double val);
 		Val(bool val);
 		Val(std::string val);
-		Val(std::shared_ptr<List> val);
-		Val(std::shared_ptr<Object> val);
+		Val(StringRef val);
+		Val(ListRef val);
+		Val(ObjectRef val);
+		Val(std::shared_ptr<Task> val);
+		Val(std::shared_ptr<Channel> val);
+		Val(MatrixRef val);
+		Val(std::shared_ptr<FileLines> val);
+		Val(BytesRef val);
+		Val(HeapRef val);
 		~Val();
 	} val;
 
 	void freeMem();
 	void setValue(const Variable& other);
+	void moveValue(Variable& other);
+	bool isString() const { return type == Type::string || type == Type::charRef; }
+	const std::string& str() const;
 
 public:
 
@@ -53,28 +93,58 @@ public:
 	static bool indexCheck(const Variable& var, size_t& out);
 	static bool numCheck(const Variable& var, double& out);
 	static bool listCheck(const Variable& var, List*& out);
+	static bool numListCheck(const Variable& var, std::vector<double>& out);
+	static bool objectCheck(const Variable& var, Object*& out);
+	static bool boolCheck(const Variable& var, bool& out);
+	static bool taskCheck(const Variable& var, Task*& out);
+	static bool channelCheck(const Variable& var, Channel*& out);
+	static bool matrixCheck(const Variable& var, Matrix*& out);
+	static bool bytesCheck(const Variable& var, Bytes*& out);
+	static bool heapCheck(const Variable& var, Heap*& out);
 
 	Variable();
 	Variable(double n);
 	Variable(int n);
 	Variable(bool b);
 	Variable(std::string s);
-	Variable(std::shared_ptr<List> l);
-	Variable(std::shared_ptr<Object> m);
+	Variable(StringRef s);
+	static Variable character(char c);
+	Variable(ListRef l);
+	Variable(ObjectRef m);
+	Variable(std::shared_ptr<Task> t);
+	Variable(std::shared_ptr<Channel> c);
+	Variable(MatrixRef m);
+	Variable(std::shared_ptr<FileLines> l);
+	Variable(BytesRef b);
+	Variable(HeapRef h);
 
 	Variable(const Variable& other);
+	Variable(Variable&& other) noexcept;
 
 	~Variable();
 
 	std::string typeString() const;
 	std::string toString() const;
 
+	size_t keyHash() const;
+	bool keyEquals(const Variable& other) const;
+
 	Variable operator+(const Variable& other) const;
 	Variable operator-(const Variable& other) const;
 	Variable operator*(const Variable& other) const;
 	Variable operator/(const Variable& other) const;
 	Variable operator%(const Variable& other) const;
 
+	// concatenates the operands of a chain of '+' at once, with the result of adding them from left to right.
+	// Operands which are not variables (e.g. comparisons) are converted to temporaries lasting until the end
+	// of the statement
+	template <typename... T>
+	static Variable concat(const T&... operands)
+	{
+		return concat({ &static_cast<const Variable&>(operands)... });
+	}
+	static Variable concat(std::initializer_list<const Variable*> operands);
+
 	void operator+=(const Variable& other);
 	void operator-=(const Variable& other);
 	void operator*=(const Variable& other);
@@ -82,6 +152,7 @@ public:
 	void operator%=(const Variable& other);
 
 	Variable& operator=(const Variable& other);
+	Variable& operator=(Variable&& other) noexcept;
 
 	bool operator==(const Variable& other) const;
 	bool operator!=(const Variable& other) const;
@@ -90,8 +161,36 @@ public:
 	bool operator>(const Variable& other) const;
 	bool operator>=(const Variable& other) const;
 
+	// reference to an element 'container[index]' or 'container[row][col]' on the left side of an
+	// assignment. Elements of bytes and matrices are stored as bytes and numbers rather than Variables,
+	// so they cannot be referred to by a Variable&
+	class ElementRef
+	{
+		Variable* var;
+		double* num;
+		uint8_t* byte;
+
+		Variable get() const;
+		void assign(const Variable& value);
+
+	public:
+		ElementRef(Variable& container, const Variable& index);
+		ElementRef(Variable& container, const Variable& row, const Variable& col);
+		void operator=(const Variable& value);
+		void operator+=(const Variable& other);
+		void operator-=(const Variable& other);
+		void operator*=(const Variable& other);
+		void operator/=(const Variable& other);
+		void operator%=(const Variable& other);
+	};
+
 	Variable& operator[](const Variable& index);
+	Variable& operator[](const FieldKey& field);
 	Variable at(const Variable& index) const;
+	Variable at(const FieldKey& field) const;
+	ElementRef element(const Variable& index);
+	ElementRef element(const Variable& row, const Variable& col);
+	Variable at(const Variable& row, const Variable& col) const;
 
 	explicit operator bool() const;
 
@@ -100,7 +199,11 @@ public:
 		Variable* container;
 		std::string::const_iterator stringIt;
 		List::iterator listIt;
-		Object::iterator objIt;
+		// the keys of an object or the values of a heap in order of priority, copied when the iteration begins
+		List copied;
+		size_t copiedIndex;
+		const char* lineIt;
+		Bytes::iterator bytesIt;
 
 	public:
 		VariableIterator(Variable* var, bool begin);
@@ -0,0 +1,25 @@
+# test of tasks which block on a channel while other threads wait: runs tests/blocking.sud on 1, 2, and 4
+# threads, and fails if a run does not finish within a minute or if its output is not the expected one.
+# Run from the SudohLang directory after setup.sh has built sudoht and the runtime library
+set -e
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+cp tests/blocking.sud "$work"
+./sudoht "$work/blocking.sud"
+g++ "$work/blocking.cpp" -I sudoh -L . -lsudoh -pthread -o "$work/blocking"
+
+expected=$(printf '8999997\n5\n7199984\n6')
+for threads in 1 2 4; do
+	if ! output=$(SUDOH_THREADS=$threads timeout 60 "$work/blocking"); then
+		echo "$threads thread(s): did not finish"
+		exit 1
+	fi
+	if [ "$output" != "$expected" ]; then
+		echo "$threads thread(s): unexpected output: $output"
+		exit 1
+	fi
+	echo "$threads thread(s): passed"
+done
+echo "blocking test passed"
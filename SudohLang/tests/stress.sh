@@ -0,0 +1,36 @@
+# stress test of values shared between threads: builds the runtime library with AddressSanitizer and
+# UndefinedBehaviorSanitizer, and then with ThreadSanitizer, and runs tests/stress.sud with each build on
+# 1, 2, and 8 threads. Fails if a sanitizer reports an error (including a leak) or if the output differs
+# between runs. Run from the SudohLang directory after setup.sh has built sudoht
+set -e
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+cp tests/stress.sud "$work"
+./sudoht "$work/stress.sud"
+
+export ASAN_OPTIONS=detect_leaks=1:halt_on_error=1
+export UBSAN_OPTIONS=halt_on_error=1:print_stacktrace=1
+export TSAN_OPTIONS=halt_on_error=1
+
+expected=""
+for sanitizers in "address,undefined" "thread"; do
+	echo "building with -fsanitize=$sanitizers"
+	mkdir -p "$work/$sanitizers"
+	(cd "$work/$sanitizers" && g++ -c -g -O1 -fsanitize=$sanitizers -I "$OLDPWD/sudoh" "$OLDPWD"/sudoh/*.cpp)
+	ar rcs "$work/$sanitizers/libsudoh.a" "$work/$sanitizers"/*.o
+	g++ -g -O1 -fsanitize=$sanitizers "$work/stress.cpp" -I sudoh -L "$work/$sanitizers" -lsudoh -pthread -o "$work/stress"
+
+	for threads in 1 2 8; do
+		output=$(SUDOH_THREADS=$threads "$work/stress")
+		echo "  $threads thread(s): $output"
+		if [ -z "$expected" ]; then
+			expected=$output
+		elif [ "$output" != "$expected" ]; then
+			echo "output differs from the first run: $expected"
+			exit 1
+		fi
+	done
+done
+echo "stress test passed"
@@ -18,7 +18,8 @@ bool NameManager::validName(const std::string& name)
 {
 	static const std::set<std::string> KEYWORDS = {
 		"if", "then", "else", "do", "not", "true", "false", "null", "repeat", "while", "until", "for",
-		"each", "in", "output", "exit", "break", "continue", "mod", "procedure", "and", "or", "including"
+		"each", "in", "output", "exit", "break", "continue", "mod", "procedure", "and", "or", "including",
+		"memoized", "parallel", "spawn"
 	};
 
 	return std::regex_match(name, NAME_RE) && KEYWORDS.count(name) == 0;
@@ -37,6 +38,25 @@ bool NameManager::varExists(const std::string& name, bool inProcedure)
 	return false;
 }
 
+// return the scope level of the innermost declaration of a variable visible at current scope, or -1 if none
+int NameManager::varScope(const std::string& name, bool inProcedure)
+{
+	for (int i = (int)varsInScopeN.size() - 1; i >= (int)inProcedure; i--)
+	{
+		if (varsInScopeN[i].count(name) != 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+// return the scope level that variables declared in the next scope will be placed in
+int NameManager::nextScope()
+{
+	return varsInScopeN.size();
+}
+
 // advances the current scope, adding more space to place new variables at top scope
 void NameManager::advanceScope()
 {
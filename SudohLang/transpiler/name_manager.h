@@ -36,7 +36,21 @@ class NameManager
 		{ "random", 1 }, { "remove", 2 }, { "removeLast", 1 }, { "append", 2 },
 		{ "insert", 3 }, { "range", 3 }, { "type", 1 }, { "pow", 2 },
 		{ "cos", 1 }, { "sin", 1 }, { "tan", 1 }, { "acos", 1 },
-		{ "asin", 1 }, { "atan", 1 }, { "atan2", 2 }, { "log", 2 }
+		{ "asin", 1 }, { "atan", 1 }, { "atan2", 2 }, { "log", 2 },
+		{ "clearMemo", 0 }, { "memoLimit", 1 }, { "memoStats", 0 }, { "await", 1 },
+		{ "channel", 1 }, { "send", 2 }, { "receive", 1 }, { "close", 1 },
+		{ "sum", 1 }, { "min", 1 }, { "max", 1 }, { "mean", 1 },
+		{ "dot", 2 }, { "scale", 2 }, { "addLists", 2 }, { "matrix", 3 },
+		{ "toMatrix", 1 }, { "toList", 1 }, { "rows", 1 }, { "columns", 1 },
+		{ "transpose", 1 }, { "multiply", 2 }, { "multiplyElements", 2 }, { "readFile", 1 },
+		{ "writeFile", 2 }, { "appendFile", 2 }, { "lines", 1 }, { "readCSV", 1 },
+		{ "readCSV", 2 }, { "parseJSON", 1 }, { "toJSON", 1 },
+		{ "save", 2 }, { "load", 1 }, { "readBytes", 1 }, { "bytes", 1 },
+		{ "bytesFromString", 1 }, { "toString", 1 }, { "find", 2 }, { "find", 3 },
+		{ "split", 2 }, { "join", 2 }, { "replace", 3 }, { "startsWith", 2 },
+		{ "endsWith", 2 }, { "trim", 1 }, { "toUpper", 1 }, { "toLower", 1 },
+		{ "matches", 2 }, { "findAll", 2 }, { "replaceAll", 3 }, { "heap", 0 },
+		{ "push", 3 }, { "pop", 1 }, { "peek", 1 }, { "decreasePriority", 3 }
 	};
 	// a list of programmer defined procedures in this source file; does not include
 	// built-in/imported procedures as in proceduresDefined
@@ -56,6 +70,8 @@ public:
 	static bool validName(const std::string& name);
 
 	bool varExists(const std::string& name, bool inFunction);
+	int varScope(const std::string& name, bool inProcedure);
+	int nextScope();
 	void addVar(const std::string& name);
 	void addVarToNextScope(const std::string& name);
 	void addProcedure(const std::string& name, int numParams);
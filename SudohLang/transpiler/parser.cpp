@@ -92,6 +92,14 @@ void Parser::parse(const std::string& fileName, bool main)
 
 		// begin transpiled file with #include "<file>"
 		trans.includeFile(fileName);
+		if (options.lineDirectives)
+		{
+			trans.enableLineDirectives(fileName + ".sud", fileName + ".cpp");
+		}
+		if (options.lineCounts)
+		{
+			trans.enableLineCounts(fileName + ".sud");
+		}
 
 		if (skipToNextRelevant() != 0)
 		{
@@ -177,14 +185,14 @@ void Parser::appendAndAdvance(const std::string append)
 }
 
 // assert that the next token is the end of a line, and commit the line
-void Parser::endOfLine()
+void Parser::endOfLine(bool statement)
 {
 	const std::string& token = tokens.currToken();
 	if (token != "\n" && token != TokenIterator::END)
 	{
 		throw SyntaxException("each statement must be on a new line; expected end of line");
 	}
-	trans.commitLine(inProcedure, currStatementScope);
+	trans.commitLine(inProcedure, currStatementScope, statement);
 }
 
 // parses one single line in the Sudoh code and commits a transpiled version it if is well-formed
@@ -195,12 +203,13 @@ bool Parser::parseNextLine(std::vector<bool(Parser::*)()>& extraRules)
 	{
 		return false;
 	}
+	trans.setSourceLine(tokens.currLineNum());
 
-	// first check if this line is a standalone procedure call or assignment statement
-	if (parseProcCall() || parseAssignment())
+	// first check if this line is a standalone procedure call (possibly started as a task) or assignment statement
+	if (parseProcCall() || parseSpawn() || parseAssignment())
 	{
 		trans.appendToBuffer(";");
-		endOfLine();
+		endOfLine(true);
 		return true;
 	}
 
@@ -212,8 +221,15 @@ bool Parser::parseNextLine(std::vector<bool(Parser::*)()>& extraRules)
 		endOfLine();
 
 		int scope = currStatementScope;
+		// the body of a 'parallel for each' loop is run separately for each element, so no rules of
+		// enclosing structures (e.g. 'break' out of an enclosing loop) apply inside of it
+		if (extraRule == &Parser::extraParseInsideParallelLoop)
+		{
+			std::vector<bool (Parser::*)()> parallelRules = { extraRule };
+			parseBlock(parallelRules);
+		}
 		// if extra parsing rule specified then parse inner block with extra rule
-		if (extraRule && std::find(extraRules.begin(), extraRules.end(), extraRule) == extraRules.end())
+		else if (extraRule && std::find(extraRules.begin(), extraRules.end(), extraRule) == extraRules.end())
 		{
 			extraRules.push_back(extraRule);
 			parseBlock(extraRules);
@@ -232,12 +248,12 @@ bool Parser::parseNextLine(std::vector<bool(Parser::*)()>& extraRules)
 		return true;
 	}
 
-	// if there are any extra rules specified at this point then check them
-	for (auto& e : extraRules)
+	// if there are any extra rules specified at this point then check them, innermost structure first
+	for (auto e = extraRules.rbegin(); e != extraRules.rend(); e++)
 	{
-		if ((this->*e)())
+		if ((this->**e)())
 		{
-			endOfLine();
+			endOfLine(true);
 			return true;
 		}
 	}
@@ -253,6 +269,28 @@ void Parser::parseBlock(std::vector<bool (Parser::*)()>& extraRules)
 	trans.commitLine(inProcedure, currStatementScope);
 
 	int blockScope = currStatementScope + 1;
+
+	// special case for beginning of procedure definition; remember where the body begins in case
+	// a tail call needs to jump back to it
+	if (inProcedure && blockScope == 1)
+	{
+		if (options.profile)
+		{
+			trans.appendToBuffer("\tstatic ProfiledProcedure* const profiled = profileProcedure(\"" + currProcName +
+				"\", " + std::to_string(currProcParams.size()) + ");");
+			trans.commitLine(inProcedure, currStatementScope);
+			trans.appendToBuffer("\tProfileScope profileScope(profiled);");
+			trans.commitLine(inProcedure, currStatementScope);
+		}
+		if (options.shadowStack)
+		{
+			trans.appendToBuffer("\tShadowFrame shadowFrame(\"" + currProcName + "/" +
+				std::to_string(currProcParams.size()) + "\");");
+			trans.commitLine(inProcedure, currStatementScope);
+		}
+		trans.markProcedureBegin();
+	}
+
 	currStatementScope = skipToNextRelevant();
 	if (currStatementScope < blockScope)
 	{
@@ -278,6 +316,11 @@ void Parser::parseBlock(std::vector<bool (Parser::*)()>& extraRules)
 	{
 		trans.appendToBuffer("\treturn null;");
 		trans.commitLine(inProcedure, currStatementScope);
+
+		if (tailCallUsed)
+		{
+			trans.insertAtProcedureBegin("tailcall:");
+		}
 	}
 
 	// add closing curly brace to indicate C++ end of block
@@ -295,15 +338,24 @@ bool Parser::parseAssignment()
 {
 	// [var] <- [expr]
 	//  ^
-	if (NameManager::validName(tokens.currToken()))
+	const std::string& name = tokens.currToken();
+	if (NameManager::validName(name))
 	{
 		size_t beginTokenNum = tokens.getTokenNum();
+		size_t beginPos = trans.bufferPosition();
+
+		// variables shared by the iterations of a 'parallel for each' loop are assigned to differently
+		bool shared = sharedByParallelLoop(name);
+		bool indexed = tokens.getTokens()[beginTokenNum + 1].tokenString == "[";
 		parseVar(true);
 
 		// [var] <- [expr]
 		//       ^
 		if (tokens.currToken() == "<-")
 		{
+			size_t opPos = trans.bufferPosition();
+			std::string compoundOp;
+
 			// check if assignment is of form [var] <- [var] [operator] [expr] to transpile to C++
 			// compound assignment statement e.g. [var] += [expr]
 
@@ -321,6 +373,7 @@ bool Parser::parseAssignment()
 				// only translate to compound assignment statements for arithmetic operations
 				if (op == "+" || op == "-" || op == "*" || op == "/" || op == "mod")
 				{
+					compoundOp = op;
 					appendAndAdvance(" " + (op == "mod" ? "%" : op) + "= ");
 				}
 				else
@@ -336,7 +389,13 @@ bool Parser::parseAssignment()
 
 			// [var] <- [expr]
 			//           ^
+			size_t exprPos = trans.bufferPosition();
 			parseExpr();
+
+			if (shared)
+			{
+				transpileParallelAssignment(beginTokenNum, indexed, beginPos, opPos, exprPos, compoundOp);
+			}
 			return true;
 		}
 		tokens.setTokenNum(beginTokenNum);
@@ -344,6 +403,67 @@ bool Parser::parseAssignment()
 	return false;
 }
 
+// returns whether a variable is declared outside of the innermost 'parallel for each' loop being parsed
+bool Parser::sharedByParallelLoop(const std::string& name)
+{
+	if (parallelLoops.empty())
+	{
+		return false;
+	}
+	int scope = names.varScope(name, inProcedure);
+	return scope != -1 && scope < parallelLoops.back().scope;
+}
+
+// rewrites a transpiled assignment to a variable shared by the iterations of a 'parallel for each' loop.
+// A shared variable itself may only be updated by a reduction e.g. 'total <- total + e', which is
+// accumulated separately by each task of the loop. An assignment to an element of a shared list or
+// object is made while holding a lock, after the value assigned has been evaluated
+void Parser::transpileParallelAssignment(size_t beginTokenNum, bool indexed, size_t beginPos, size_t opPos,
+	size_t exprPos, const std::string& compoundOp)
+{
+	const std::string& name = tokens.getTokens()[beginTokenNum].tokenString;
+	std::string assignment = trans.takeFromBuffer(beginPos);
+	std::string expr = assignment.substr(exprPos - beginPos);
+
+	if (indexed)
+	{
+		trans.appendToBuffer("{ var ps = " + expr + "; ParallelStore store; " +
+			assignment.substr(0, exprPos - beginPos) + "ps; }");
+		return;
+	}
+
+	if (compoundOp != "+" && compoundOp != "-" && compoundOp != "*")
+	{
+		throw SyntaxException("variable '" + name + "' is shared by all iterations of the 'parallel for each' loop; it may "
+			"only be updated by a reduction of the form '" + name + " <- " + name + " (+|-|*) <expression>'", beginTokenNum);
+	}
+	int scope = names.varScope(name, inProcedure);
+	for (size_t i = 0; i + 1 < parallelLoops.size(); i++)
+	{
+		if (scope < parallelLoops[i].scope)
+		{
+			throw SyntaxException("cannot make a reduction to variable '" + name + "' shared by an enclosing "
+				"'parallel for each' loop", beginTokenNum);
+		}
+	}
+
+	// reductions to the same variable share an accumulator
+	auto& reductions = parallelLoops.back().reductions;
+	size_t index;
+	for (index = 0; index < reductions.size() && reductions[index].first != name; index++);
+	if (index == reductions.size())
+	{
+		reductions.push_back({ name, compoundOp[0] });
+	}
+	else if (reductions[index].second != compoundOp[0])
+	{
+		throw SyntaxException("reductions to variable '" + name + "' in the same 'parallel for each' loop must all "
+			"use the same operator", beginTokenNum);
+	}
+
+	trans.appendToBuffer("reductions.add(" + std::to_string(index) + ", '" + compoundOp + "', " + expr + ")");
+}
+
 // parse a procedure call
 bool Parser::parseProcCall()
 {
@@ -381,6 +501,53 @@ bool Parser::parseProcCall()
 	return false;
 }
 
+// parse a procedure call started as a task e.g. 'spawn [name]({params})', which is transpiled into
+// 'spawnTask((var(*)(var...))p_[name], {params})'; the procedure call is checked in the same way as an ordinary call
+bool Parser::parseSpawn()
+{
+	if (tokens.currToken() != "spawn")
+	{
+		return false;
+	}
+	tokens.advance();
+
+	// spawn [name]({params})
+	//        ^
+	const std::string& procName = tokens.currToken();
+	size_t procCallTokenNum = tokens.getTokenNum();
+	if (!NameManager::validName(procName) || tokens.getTokens()[procCallTokenNum + 1].tokenString != "(")
+	{
+		throw SyntaxException("expected procedure call after 'spawn'");
+	}
+	size_t spawnPos = trans.bufferPosition();
+	tokens.advance();
+	tokens.advance();
+
+	// spawn [name]({params})
+	//              ^
+	int numParams = parseCommaSep(&Parser::parseExpr, ")");
+	std::string params = trans.takeFromBuffer(spawnPos);
+
+	// spawn [name]({params})
+	//                      ^
+	if (tokens.currToken() != ")")
+	{
+		throw SyntaxException("expected closing parenthesis for procedure call");
+	}
+
+	// the procedure is cast to the type of the procedure with this many parameters, as there may be others
+	// with the same name e.g. 'spawn f(a, b)' to 'spawnTask((var(*)(var, var))p_f, a, b)'
+	std::string procType = "var(*)(";
+	for (int i = 0; i < numParams; i++)
+	{
+		procType += i == 0 ? "var" : ", var";
+	}
+	trans.appendToBuffer("spawnTask((" + procType + "))p_" + procName + (numParams == 0 ? "" : ", ") + params);
+	appendAndAdvance(")");
+	names.addProcedureCall(procName, numParams, procCallTokenNum);
+	return true;
+}
+
 // parse an expression that indicates a variable
 bool Parser::parseVar(bool lvalue)
 {
@@ -390,25 +557,65 @@ bool Parser::parseVar(bool lvalue)
 		bool exists = names.varExists(name, inProcedure);
 		parseVarName(lvalue ? VarParseMode::mayBeNew : VarParseMode::mustExist);
 
-		// also accept list, string, or object indexed values as variables
+		// also accept list, string, object, or matrix indexed values as variables; an index which is a
+		// string literal e.g. node["next"] is translated to FIELD("next"), which caches where the field is
+		// found in objects with a shape
+		const std::string open = lvalue ? "[" : ".at(", close = lvalue ? "]" : ")";
+		std::vector<std::string> indices;
+		std::vector<bool> fields;
 		while (tokens.currToken() == "[")
 		{
 			if (!exists)
 			{
 				throw SyntaxException("cannot index into undeclared variable");
 			}
-			// translate to var[x] for attempted assignment and var.at(x) for attempted access
-			appendAndAdvance(lvalue ? "[" : ".at(");
+			tokens.advance();
 
 			// value inside of brackets must be an expression
-			parseExpr();
+			const std::string& token = tokens.currToken();
+			bool field = token.length() >= 2 && token.front() == '"' && token.find('\\') == std::string::npos &&
+				tokens.getTokens()[tokens.getTokenNum() + 1].tokenString == "]";
+			size_t indexPos = trans.bufferPosition();
+			if (field)
+			{
+				appendAndAdvance("FIELD(" + token + ")");
+			}
+			else
+			{
+				parseExpr();
+			}
+			indices.push_back(trans.takeFromBuffer(indexPos));
+			fields.push_back(field);
 
-			if (tokens.currToken() == "]")
+			if (tokens.currToken() != "]")
 			{
-				appendAndAdvance(lvalue ? "]" : ")");
-				continue;
+				throw SyntaxException("expected closing bracket");
 			}
-			throw SyntaxException("expected closing bracket");
+			tokens.advance();
+		}
+
+		// translate to var[x] for attempted assignment and var.at(x) for attempted access. The last two
+		// indices are translated together to var.element(x, y) for attempted assignment and var.at(x, y)
+		// for attempted access, so that an element of a matrix is accessed directly, unless either is a
+		// field (as a matrix has no fields)
+		size_t n = indices.size();
+		bool pair = n >= 2 && !fields[n - 2] && !fields[n - 1];
+		for (size_t i = 0; i < n - (pair ? 2 : 0); i++)
+		{
+			// a last single index is translated to var.element(x) for attempted assignment, so that a byte
+			// of bytes can be assigned to
+			if (lvalue && i == n - 1 && !fields[i])
+			{
+				trans.appendToBuffer(".element(" + indices[i] + ")");
+			}
+			else
+			{
+				trans.appendToBuffer(open + indices[i] + close);
+			}
+		}
+		if (pair)
+		{
+			trans.appendToBuffer((lvalue ? ".element(" : ".at(") + indices[n - 2] + ", " + indices[n - 1] + ")");
 		}
 		return true;
 	}
@@ -448,6 +655,11 @@ bool Parser::parseVarName(VarParseMode mode)
 			}
 			throw SyntaxException("use of undeclared variable " + name);
 		case VarParseMode::forVar:
+			if (sharedByParallelLoop(name))
+			{
+				throw SyntaxException("'for' loop iteration variable '" + name + "' cannot be a variable shared by all "
+					"iterations of the enclosing 'parallel for each' loop");
+			}
 			if (names.varExists(name, inProcedure))
 			{
 				appendAndAdvance("v_" + name);
@@ -488,7 +700,7 @@ static const std::set<ParsedType> ALL = {
 // helper function for parseExprBinary which checks integrity of binary operation by checking
 // if operation between two specified types is allowed
 void Parser::checkBinary(const std::string translatedBinOp, ParsedType& leftType,
-	const Operations& allowedOps, void (Parser::*rightFunction)(ParsedType&))
+	const Operations& allowedOps, void (Parser::*rightFunction)(ParsedType&), ParsedType* rightTypeOut)
 {
 	size_t initTokenNum = tokens.getTokenNum();
 
@@ -501,6 +713,10 @@ void Parser::checkBinary(const std::string translatedBinOp, ParsedType& leftType
 	// operation between these two types is legal
 	ParsedType rightType;
 	(this->*rightFunction)(rightType);
+	if (rightTypeOut)
+	{
+		*rightTypeOut = rightType;
+	}
 
 	if (rightType == ParsedType::any)
 	{
@@ -520,21 +736,33 @@ void Parser::checkBinary(const std::string translatedBinOp, ParsedType& leftType
 
 void Parser::parseArithmetic(ParsedType& type)
 {
+	size_t beginPos = trans.bufferPosition();
 	parseTerm(type);
+
+	// positions of the ' + ' between the operands of a chain of '+', which is transpiled to a single
+	// concatenation if any operand is a string and there is no '-' (which C++ would group differently)
+	std::vector<size_t> plusPositions;
+	bool concatenation = type == ParsedType::string;
+	bool minus = false;
+
 	const std::string* token = &tokens.currToken();
 	while (*token == "+" || *token == "-" || *token == "*" || *token == "/" || *token == "mod")
 	{
 		if (*token == "+")
 		{
+			plusPositions.push_back(trans.bufferPosition());
+			ParsedType rightType;
 			checkBinary(*token, type, {
 				{ ParsedType::number, { ParsedType::number } },
 				{ ParsedType::string, ALL },
 				{ ParsedType::list, ALL },
 				{ ParsedType::any, ALL }
-				}, &Parser::parseTerm);
+				}, &Parser::parseTerm, &rightType);
+			concatenation = concatenation || rightType == ParsedType::string;
 		}
 		else
 		{
+			minus = minus || *token == "-";
 			checkBinary(*token == "mod" ? "%" : *token, type, {
 				{ ParsedType::number, { ParsedType::number } },
 				{ ParsedType::any, { ParsedType::number }}
@@ -542,6 +770,21 @@ void Parser::parseArithmetic(ParsedType& type)
 		}
 		token = &tokens.currToken();
 	}
+
+	// a + b + c is transpiled to var::concat(a, b, c), which allocates the concatenated string once; the
+	// operands of '*', '/' and '%' between them are kept together, as C++ evaluates those first
+	if (concatenation && !minus && plusPositions.size() >= 2)
+	{
+		std::string expr = trans.takeFromBuffer(beginPos);
+		std::string concat = "var::concat(";
+		size_t operandBegin = 0;
+		for (size_t position : plusPositions)
+		{
+			concat += expr.substr(operandBegin, position - beginPos - operandBegin) + ", ";
+			operandBegin = position - beginPos + std::string(" + ").length();
+		}
+		trans.appendToBuffer(concat + expr.substr(operandBegin) + ")");
+	}
 }
 
 void Parser::parseComparison(ParsedType& type)
@@ -669,7 +912,16 @@ void Parser::parseTerm(ParsedType& t)
 	}
 	else if (std::regex_match(token, STRING_RE)) // check for string
 	{
-		appendAndAdvance("var(std::string(" + token + "))");
+		// literals of one character (or escape sequence) become characters, which need no allocation
+		std::string text = token.substr(1, token.length() - 2);
+		if (text.length() == 1 || (text.length() == 2 && text[0] == '\\'))
+		{
+			appendAndAdvance("var::character('" + (text == "'" ? "\\'" : text) + "')");
+		}
+		else
+		{
+			appendAndAdvance("var(std::string(" + token + "))");
+		}
 		t = ParsedType::string;
 	}
 	else if (token == "null") // check for null value
@@ -693,7 +945,9 @@ void Parser::parseTerm(ParsedType& t)
 	}
 	else if (token == "{") // check for object
 	{
+		size_t literalPos = trans.bufferPosition();
 		appendAndAdvance("var(OBJECT{ ");
+		objectLiterals.emplace_back();
 		maybeMultiline();
 		parseCommaSep(&Parser::parseObjectEntry, "}");
 		maybeMultiline();
@@ -702,9 +956,10 @@ void Parser::parseTerm(ParsedType& t)
 			throw SyntaxException("expected closing '}'");
 		}
 		appendAndAdvance(" })");
+		shapeObjectLiteral(literalPos);
 		t = ParsedType::object;
 	}
-	else if (parseProcCall() || parseVar(false)) // check if this is valid variable-type expression indicating 'any' type
+	else if (parseSpawn() || parseProcCall() || parseVar(false)) // check if this is valid variable-type expression indicating 'any' type
 	{
 		t = ParsedType::any;
 	}
@@ -731,6 +986,23 @@ bool Parser::extraParseInsideLoop()
 	return false;
 }
 
+// extra rules for parsing statements inside of a 'parallel for each' loop; the loop body is transpiled into
+// a lambda which is called for each element, so 'continue' returns from it
+bool Parser::extraParseInsideParallelLoop()
+{
+	const std::string& t = tokens.currToken();
+	if (t == "continue")
+	{
+		appendAndAdvance("return;");
+		return true;
+	}
+	if (t == "break" || t == "output" || t == "exit")
+	{
+		throw SyntaxException("'" + t + "' cannot be used inside of a 'parallel for each' loop");
+	}
+	return false;
+}
+
 // extra rules for parsing statements inside of a procedure
 bool Parser::extraParseInsideProcedure()
 {
@@ -741,7 +1013,13 @@ bool Parser::extraParseInsideProcedure()
 	}
 	else if (tokens.currToken() == "output")
 	{
-		appendAndAdvance("return ");
+		tokens.advance();
+		if (parseTailCall())
+		{
+			return true;
+		}
+
+		trans.appendToBuffer("return ");
 		parseExpr();
 		trans.appendToBuffer(";");
 		return true;
@@ -749,6 +1027,81 @@ bool Parser::extraParseInsideProcedure()
 	return false;
 }
 
+// parse 'output [name]({params})' where the procedure being called is the procedure currently being
+// defined (with the same number of parameters). Such a call is transpiled into reassignment of the
+// procedure parameters followed by a jump back to the beginning of the procedure body
+bool Parser::parseTailCall()
+{
+	auto& tList = tokens.getTokens();
+	size_t beginTokenNum = tokens.getTokenNum();
+
+	// output [name]({params})
+	//         ^
+	// recursive calls in memoized procedures are left as calls so that their outputs are cached as well
+	if (currProcMemoized || tokens.currToken() != currProcName || tList[beginTokenNum + 1].tokenString != "(")
+	{
+		return false;
+	}
+
+	// find the closing parenthesis of the call, counting the parameters passed at the top level
+	int depth = 0;
+	int numParams = 1;
+	size_t closeTokenNum;
+	for (closeTokenNum = beginTokenNum + 1; closeTokenNum < tList.size(); closeTokenNum++)
+	{
+		const std::string& t = tList[closeTokenNum].tokenString;
+		if (t == TokenIterator::END)
+		{
+			return false;
+		}
+		if (t == "(" || t == "[" || t == "{")
+		{
+			depth++;
+		}
+		else if (t == ")" || t == "]" || t == "}")
+		{
+			if (--depth == 0)
+			{
+				break;
+			}
+		}
+		else if (depth == 1 && t == ",")
+		{
+			numParams++;
+		}
+	}
+	if (tList[beginTokenNum + 2].tokenString == ")")
+	{
+		numParams = 0;
+	}
+
+	// output [name]({params})
+	//                        ^
+	// the call must be the entire output expression and must call this exact procedure
+	const std::string& after = tList[closeTokenNum + 1].tokenString;
+	if ((after != "\n" && after != TokenIterator::END) || numParams != (int)currProcParams.size())
+	{
+		return false;
+	}
+
+	tokens.advance();
+	tokens.advance();
+
+	// evaluate all new parameter values before any parameter is reassigned, as the
+	// expressions may refer to the current parameter values
+	trans.appendToBuffer("{ ");
+	tailCallParamNum = 0;
+	parseCommaSep(&Parser::parseTailCallParameter, ")", false);
+	for (int i = 0; i < numParams; i++)
+	{
+		trans.appendToBuffer("v_" + currProcParams[i] + " = tc_" + std::to_string(i) + "; ");
+	}
+	appendAndAdvance("goto tailcall; }");
+
+	tailCallUsed = true;
+	return true;
+}
+
 // extra rules for parsing statements after an 'if' block
 void Parser::parseAfterIf(int scope, std::vector<bool (Parser::*)()>& extraRules)
 {
@@ -758,6 +1111,7 @@ void Parser::parseAfterIf(int scope, std::vector<bool (Parser::*)()>& extraRules
 	{
 		if (tokens.currToken() == "else")
 		{
+			trans.setSourceLine(tokens.currLineNum());
 			if (elseReached)
 			{
 				throw SyntaxException("'else' block already reached");
@@ -768,7 +1122,7 @@ void Parser::parseAfterIf(int scope, std::vector<bool (Parser::*)()>& extraRules
 			//      ^
 			if (tokens.currToken() == "if")
 			{
-				appendAndAdvance(" if (");
+				appendAndAdvance(" if (" + trans.lineCountExpr());
 
 				// else if [b] then
 				//          ^
@@ -807,7 +1161,8 @@ void Parser::parseAfterRepeat(int scope, std::vector<bool (Parser::*)()>& extraR
 		// either 'repeat ... while <condition>' or 'repeat ... until <condition>' are valid
 		if (token == "while" || token == "until")
 		{
-			appendAndAdvance("while (" + std::string(token == "until" ? "!(" : ""));
+			trans.setSourceLine(tokens.currLineNum());
+			appendAndAdvance("while (" + trans.lineCountExpr() + (token == "until" ? "!(" : ""));
 
 			parseExpr({ ParsedType::boolean });
 			trans.appendToBuffer(token == "until" ? "));" : ");");
@@ -822,9 +1177,59 @@ void Parser::afterProcedure(int scope, std::vector<bool(Parser::*)()>& extraRule
 {
 	// add empty line to separate generated functions
 	trans.commitLine(inProcedure, currStatementScope);
+
+	if (currProcMemoized)
+	{
+		trans.setSourceLine(currProcLine);
+		transpileMemoizedWrapper();
+	}
 	inProcedure = false;
 }
 
+// pass the variables of the reductions made in a 'parallel for each' loop to the loop after its body
+void Parser::afterParallelLoop(int scope, std::vector<bool(Parser::*)()>& extraRules)
+{
+	std::string reductions;
+	for (auto& e : parallelLoops.back().reductions)
+	{
+		reductions += std::string(reductions.empty() ? "" : ", ") + "{ v_" + e.first + ", '" + e.second + "' }";
+	}
+	trans.appendToLastLine(inProcedure, reductions.empty() ? ");" : ", { " + reductions + " });");
+	parallelLoops.pop_back();
+}
+
+// a memoized procedure's body is transpiled into 'm_[name]'; this adds the actual 'p_[name]' procedure,
+// which looks up the parameter values in a cache of previous outputs before calling 'm_[name]'
+void Parser::transpileMemoizedWrapper()
+{
+	std::string params, args;
+	for (size_t i = 0; i < currProcParams.size(); i++)
+	{
+		params += (i == 0 ? "var v_" : ", var v_") + currProcParams[i];
+		args += (i == 0 ? "v_" : ", v_") + currProcParams[i];
+	}
+
+	const std::vector<std::string> lines = {
+		"var p_" + currProcName + "(" + params + ")",
+		"{",
+		"\tstatic MemoTable memo(\"" + currProcName + "\", " + std::to_string(currProcParams.size()) + ");",
+		"\tMemoTable::Key key = { " + args + " };",
+		"\tvar cached;",
+		"\tif (memo.find(key, cached))",
+		"\t{",
+		"\t\treturn cached;",
+		"\t}",
+		"\treturn memo.store(key, m_" + currProcName + "(" + args + "));",
+		"}",
+		""
+	};
+	for (const std::string& e : lines)
+	{
+		trans.appendToBuffer(e);
+		trans.commitLine(inProcedure, 0);
+	}
+}
+
 // parse a programming structure such as a loop, if statement, or procedure declaration and return
 // whether a structure was found (and output values to parse parameters if needed)
 bool Parser::parseStructure(bool (Parser::*& additionalRule)(), void (Parser::*& parseAfter)(int, std::vector<bool (Parser::*)()>&))
@@ -833,7 +1238,7 @@ bool Parser::parseStructure(bool (Parser::*& additionalRule)(), void (Parser::*&
 
 	if (*token == "if")
 	{
-		appendAndAdvance("if (");
+		appendAndAdvance("if (" + trans.lineCountExpr());
 
 		// if [b] then
 		//     ^
@@ -852,7 +1257,7 @@ bool Parser::parseStructure(bool (Parser::*& additionalRule)(), void (Parser::*&
 
 	if (*token == "while" || *token == "until")
 	{
-		appendAndAdvance("while (" + std::string(*token == "until" ? "!(" : ""));
+		appendAndAdvance("while (" + trans.lineCountExpr() + (*token == "until" ? "!(" : ""));
 
 		// while [b] do
 		//        ^
@@ -889,7 +1294,7 @@ bool Parser::parseStructure(bool (Parser::*& additionalRule)(), void (Parser::*&
 				// for i <- [n] (down)? to [n] do
 				//           ^
 				parseExpr({ ParsedType::number });
-				trans.appendToBuffer("; v_" + forVar);
+				trans.appendToBuffer("; " + trans.lineCountExpr() + "v_" + forVar);
 
 				// for i <- [n] (down)? to [n] do
 				//              ^
@@ -937,7 +1342,10 @@ bool Parser::parseStructure(bool (Parser::*& additionalRule)(), void (Parser::*&
 				//            ^
 				if (tokens.currToken() == "in")
 				{
-					appendAndAdvance(" : ");
+					// when lines are counted, the collection is wrapped so that each check for its end is
+					// counted, as is each evaluation of the condition of any other loop
+					std::string counter = trans.lineCounter();
+					appendAndAdvance(counter.empty() ? " : " : " : CountedIterations(" + counter + ", ");
 					static std::set<ParsedType> valid = {
 						ParsedType::string, ParsedType::list,
 						ParsedType::object, ParsedType::any
@@ -951,7 +1359,7 @@ bool Parser::parseStructure(bool (Parser::*& additionalRule)(), void (Parser::*&
 					//                   ^
 					if (tokens.currToken() == "do")
 					{
-						appendAndAdvance(")");
+						appendAndAdvance(counter.empty() ? ")" : "))");
 						additionalRule = &Parser::extraParseInsideLoop;
 						return true;
 					}
@@ -964,6 +1372,55 @@ bool Parser::parseStructure(bool (Parser::*& additionalRule)(), void (Parser::*&
 		throw SyntaxException("invalid 'for' loop statement");
 	}
 
+	// parallel for each e in [list] do
+	//  ^
+	if (*token == "parallel")
+	{
+		tokens.advance();
+		if (tokens.currToken() != "for" || tokens.getTokens()[tokens.getTokenNum() + 1].tokenString != "each")
+		{
+			throw SyntaxException("expected 'for each' after 'parallel'");
+		}
+		tokens.advance();
+		tokens.advance();
+
+		// parallel for each e in [list] do
+		//                   ^
+		// the iteration variable is a parameter of the lambda the loop body is transpiled into
+		if (!NameManager::validName(tokens.currToken()))
+		{
+			throw SyntaxException("expected declaration of 'parallel for each' loop iteration variable");
+		}
+		size_t varPos = trans.bufferPosition();
+		parseVarName(VarParseMode::forEachVar);
+		std::string iterVar = trans.takeFromBuffer(varPos);
+
+		// parallel for each e in [list] do
+		//                     ^
+		if (tokens.currToken() != "in")
+		{
+			throw SyntaxException("expected 'in'");
+		}
+		// the line of the loop is counted once each time the loop begins
+		appendAndAdvance(trans.lineCountExpr() + "parallelForEach(");
+
+		// parallel for each e in [list] do
+		//                         ^
+		parseExpr({ ParsedType::list });
+
+		// parallel for each e in [list] do
+		//                                ^
+		if (tokens.currToken() == "do")
+		{
+			appendAndAdvance(", [&](ParallelReductions& reductions, " + iterVar + ")");
+			parallelLoops.push_back({ names.nextScope(), {} });
+			additionalRule = &Parser::extraParseInsideParallelLoop;
+			parseAfter = &Parser::afterParallelLoop;
+			return true;
+		}
+		throw SyntaxException("expected 'do'");
+	}
+
 	if (*token == "repeat")
 	{
 		appendAndAdvance("do");
@@ -972,6 +1429,20 @@ bool Parser::parseStructure(bool (Parser::*& additionalRule)(), void (Parser::*&
 		return true;
 	}
 
+	// memoized procedure [name] -> {params}
+	//  ^
+	bool memoized = false;
+	if (*token == "memoized")
+	{
+		tokens.advance();
+		token = &tokens.currToken();
+		if (*token != "procedure")
+		{
+			throw SyntaxException("expected 'procedure' after 'memoized'");
+		}
+		memoized = true;
+	}
+
 	if (*token == "procedure")
 	{
 		if (inProcedure)
@@ -979,15 +1450,21 @@ bool Parser::parseStructure(bool (Parser::*& additionalRule)(), void (Parser::*&
 			throw SyntaxException("nested procedure illegal");
 		}
 
-		appendAndAdvance("var ");
+		// the body of a memoized procedure is only called through its caching wrapper
+		appendAndAdvance(memoized ? "static var " : "var ");
 		const std::string& procName = tokens.currToken();
 
 		// procedure [name] -> {params}
 		//            ^
 		if (NameManager::validName(procName))
 		{
-			appendAndAdvance("p_" + procName + "(");
+			appendAndAdvance((memoized ? "m_" : "p_") + procName + "(");
 			inProcedure = true;
+			currProcMemoized = memoized;
+			currProcName = procName;
+			currProcLine = tokens.currLineNum();
+			currProcParams.clear();
+			tailCallUsed = false;
 
 			int numParams = 0;
 			// procedure [name] -> {params}
@@ -1031,9 +1508,18 @@ bool Parser::parseStructure(bool (Parser::*& additionalRule)(), void (Parser::*&
 
 void Parser::parseProcedureParameter()
 {
+	currProcParams.push_back(tokens.currToken());
 	parseVarName(VarParseMode::procedureParam);
 }
 
+// parse a single parameter of a tail call into a temporary variable
+void Parser::parseTailCallParameter()
+{
+	trans.appendToBuffer("var tc_" + std::to_string(tailCallParamNum++) + " = ");
+	parseExpr();
+	trans.appendToBuffer("; ");
+}
+
 void Parser::parseIncludeFile()
 {
 	const std::string& inclFileName = tokens.currToken();
@@ -1042,7 +1528,7 @@ void Parser::parseIncludeFile()
 		throw SyntaxException("invalid file name");
 	}
 
-	Parser p;
+	Parser p(options);
 	p.parse(inclFileName, false);
 	names.importProcedures(p.names.getProceduresDefined(), inclFileName);
 
@@ -1057,15 +1543,58 @@ void Parser::parseObjectEntry()
 
 	trans.appendToBuffer("{ ");
 
+	// keys which are string literals (without escape sequences) are recorded along with their values, so
+	// that the object can be given a shape if all of its keys are
+	std::string key = tokens.currToken();
+	if (key.length() < 2 || key.front() != '"' || key.find('\\') != std::string::npos ||
+		tokens.getTokens()[tokens.getTokenNum() + 1].tokenString != "<-")
+	{
+		key.clear();
+	}
+
 	parseExpr({ ParsedType::string });
 	if (tokens.currToken() != "<-")
 	{
 		throw SyntaxException("object entry must be of form <field> <- <value>");
 	}
 	appendAndAdvance(", ");
+	size_t valuePos = trans.bufferPosition();
 	parseExpr();
+	std::string value = trans.takeFromBuffer(valuePos);
+	trans.appendToBuffer(value + " }");
+
+	objectLiterals.back().push_back({ key, value });
+}
+
+// an object literal whose keys are all distinct string literals is translated to an object with a shape
+// shared by all objects made by the literal, which holds its values in an array rather than a map e.g.
+// { "val" <- v, "next" <- null } to var(OBJECT(SHAPE("val", "next"), { v_v, null }))
+void Parser::shapeObjectLiteral(size_t literalPos)
+{
+	std::vector<std::pair<std::string, std::string>> entries = std::move(objectLiterals.back());
+	objectLiterals.pop_back();
+
+	std::set<std::string> keys;
+	for (const auto& entry : entries)
+	{
+		if (entry.first.empty() || !keys.insert(entry.first).second)
+		{
+			return;
+		}
+	}
+	if (entries.empty())
+	{
+		return;
+	}
 
-	trans.appendToBuffer(" }");
+	trans.takeFromBuffer(literalPos);
+	std::string shape, values;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		shape += (i == 0 ? "" : ", ") + entries[i].first;
+		values += (i == 0 ? "" : ", ") + entries[i].second;
+	}
+	trans.appendToBuffer("var(OBJECT(SHAPE(" + shape + "), { " + values + " }))");
 }
 
 // parses a comma-separated list of items and returns number of items found
@@ -9,9 +9,24 @@
 // all types in Sudoh. 'any' is used for variables or function calls as their type is not static
 enum class ParsedType { number, boolean, string, list, object, null, any };
 
+// options which change how Sudoh source files are transpiled; set with sudoht command line flags
+struct TranspileOptions
+{
+	// emit '#line' directives which map the generated C++ code back to lines of the Sudoh source file
+	bool lineDirectives = false;
+	// instrument procedures to record call counts and time spent in them
+	bool profile = false;
+	// instrument statements to count how many times each source line is executed
+	bool lineCounts = false;
+	// instrument procedures to maintain a shadow stack of procedure names for the sampling profiler
+	bool shadowStack = false;
+};
+
 // main class for parsing/transpiling a Sudoh source file. Uses a grammar to parse contents of file
 class Parser
 {
+	const TranspileOptions options;
+
 	TranspiledBuffer trans;
 	NameManager names;
 	TokenIterator tokens;
@@ -20,6 +35,28 @@ class Parser
 	bool inProcedure;
 	int currStatementScope;
 
+	// name and parameter names of the procedure currently being parsed, used for tail call elimination
+	std::string currProcName;
+	int currProcLine;
+	std::vector<std::string> currProcParams;
+	// flag for whether the current procedure has been declared 'memoized'
+	bool currProcMemoized;
+	// flag for whether a tail call has been transpiled into a jump in the current procedure
+	bool tailCallUsed;
+	int tailCallParamNum;
+
+	// a 'parallel for each' loop being parsed; variables declared in scopes below 'scope' are shared by all
+	// iterations of the loop, and may only be updated by reductions, which are numbered in order of appearance
+	struct ParallelLoop
+	{
+		int scope;
+		std::vector<std::pair<std::string, char>> reductions;
+	};
+	// all 'parallel for each' loops the parser is currently inside of; innermost loop last
+	std::vector<ParallelLoop> parallelLoops;
+	// the entries (string literal key, or "" if the key is not one, and value) of each object literal being parsed
+	std::vector<std::vector<std::pair<std::string, std::string>>> objectLiterals;
+
 	int skipToNextRelevant();
 	// adds a string to the uncommitted transpiled C++ code buffer and advances tokenNum
 	void appendAndAdvance(const std::string append);
@@ -27,26 +64,34 @@ class Parser
 	// +-------------------------------+
 	// |   Grammar parsing functions   |
 	// +-------------------------------+
-	void endOfLine();
+	void endOfLine(bool statement = false);
 	void maybeMultiline();
 
 	bool parseNextLine(std::vector<bool(Parser::*)()>& extraRules);
 	void parseBlock(std::vector<bool(Parser::*)()>& extraRules);
 	bool extraParseInsideLoop();
 	bool extraParseInsideProcedure();
+	bool extraParseInsideParallelLoop();
 	void parseAfterIf(int scope, std::vector<bool(Parser::*)()>& extraRules);
 	void parseAfterRepeat(int scope, std::vector<bool(Parser::*)()>& extraRules);
 	void afterProcedure(int scope, std::vector<bool(Parser::*)()>& extraRules);
+	void afterParallelLoop(int scope, std::vector<bool(Parser::*)()>& extraRules);
+	void transpileMemoizedWrapper();
 	bool parseStructure(bool (Parser::*&additionalRule)(), void (Parser::*&parseAfter)(int, std::vector<bool (Parser::*)()>&));
 	bool parseAssignment();
+	bool sharedByParallelLoop(const std::string& name);
+	void transpileParallelAssignment(size_t beginTokenNum, bool indexed, size_t beginPos, size_t opPos,
+		size_t exprPos, const std::string& compoundOp);
 	bool parseProcCall();
+	bool parseTailCall();
+	bool parseSpawn();
 	bool parseVar(bool lvalue);
 	enum struct VarParseMode { mayBeNew, mustExist, procedureParam, forVar, forEachVar };
 	bool parseVarName(VarParseMode mode);
 
 	typedef std::map<ParsedType, std::set<ParsedType>> Operations;
 	void checkBinary(const std::string translatedBinOp, ParsedType& leftType,
-		const Operations& allowedOps, void (Parser::*rightFunction)(ParsedType&));
+		const Operations& allowedOps, void (Parser::*rightFunction)(ParsedType&), ParsedType* rightTypeOut = nullptr);
 	void parseTerm(ParsedType& t);
 	void parseArithmetic(ParsedType& type);
 	void parseComparison(ParsedType& type);
@@ -56,11 +101,15 @@ class Parser
 	
 	void parseIncludeFile();
 	void parseProcedureParameter();
+	void parseTailCallParameter();
 	void parseObjectEntry();
+	void shapeObjectLiteral(size_t literalPos);
 	int parseCommaSep(void (Parser::*parseItem)(), const std::string stop, bool printComma = true);
 
 public:
-	Parser() : inProcedure(false), currStatementScope(0) {}
+	Parser(const TranspileOptions opts) : options(opts), inProcedure(false), currStatementScope(0), currProcLine(0),
+		currProcMemoized(false), tailCallUsed(false), tailCallParamNum(0) {}
+	Parser() : Parser(TranspileOptions()) {}
 	void parse(const std::string& fileName, bool main);
 };
 
@@ -1,26 +1,68 @@
-//#include "parser.h"
-//#include <iostream>
-//
-//int main(int argc, char** argv)
-//{
-//	if (argc != 2)
-//	{
-//		std::cout << "Usage: sudohc <file.sud>\n";
-//		return 1;
-//	}
-//	const std::string fileName = argv[1];
-//	size_t index = fileName.find(".sud");
-//	if (index != fileName.length() - 4)
-//	{
-//		std::cout << "File extension must be '.sud'\n";
-//		return 1;
-//	}
-//
-//	const std::string noExtension = fileName.substr(0, index);
-//
-//	Parser p;
-//	p.parse("examples/sort", true);
-//	std::cout << "Transpilation successful.\n";
-//
-//	return 0;
-//}
+#include "parser.h"
+#include <iostream>
+
+// prints command line usage of sudoht
+void printUsage()
+{
+	std::cout << "Usage: sudoht [options] <file.sud>\n"
+		"Options:\n"
+		"  --line-directives  emit #line directives so that debuggers and profilers report .sud file lines\n"
+		"  --profile          record calls of and time spent in each procedure; written to a file on exit\n"
+		"  --line-counts      count executions of each source line; written to a file on exit\n"
+		"  --sample           track procedure calls for the sampling profiler (enabled by setting SUDOH_SAMPLE)\n";
+}
+
+int main(int argc, char** argv)
+{
+	TranspileOptions options;
+	std::string fileName;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--line-directives")
+		{
+			options.lineDirectives = true;
+		}
+		else if (arg == "--profile")
+		{
+			options.profile = true;
+		}
+		else if (arg == "--line-counts")
+		{
+			options.lineCounts = true;
+		}
+		else if (arg == "--sample")
+		{
+			options.shadowStack = true;
+		}
+		else if (fileName.empty() && arg[0] != '-')
+		{
+			fileName = arg;
+		}
+		else
+		{
+			printUsage();
+			return 1;
+		}
+	}
+	if (fileName.empty())
+	{
+		printUsage();
+		return 1;
+	}
+
+	size_t index = fileName.rfind(".sud");
+	if (index == std::string::npos || index != fileName.length() - 4)
+	{
+		std::cout << "File extension must be '.sud'\n";
+		return 1;
+	}
+
+	const std::string noExtension = fileName.substr(0, index);
+
+	Parser p(options);
+	p.parse(noExtension, true);
+	std::cout << "Transpilation successful.\n";
+
+	return 0;
+}
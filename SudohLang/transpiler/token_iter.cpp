@@ -114,6 +114,12 @@ const std::string& TokenIterator::currToken()
 	return tokens[tokenNum].tokenString;
 }
 
+// returns the source file line of the token that the parser is currently on
+int TokenIterator::currLineNum()
+{
+	return tokens[tokenNum].lineNum;
+}
+
 void TokenIterator::advance()
 {
 	if (tokenNum < tokens.size())
@@ -36,6 +36,7 @@ public:
 
 	// returns string of the token that the parser is currently on
 	const std::string& currToken();
+	int currLineNum();
 	void advance();
 
 	const std::vector<Token>& getTokens();
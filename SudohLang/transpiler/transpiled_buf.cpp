@@ -1,17 +1,60 @@
 #include "transpiled_buf.h"
 
+// placeholder for a '#line' directive referring a line back to the transpiled file, which is only written
+// once the final position of the line in the transpiled file is known
+static const std::string GENERATED_LINE = "#line generated";
+
+// escapes a string to be placed into a C++ string literal
+static std::string escapeString(const std::string str)
+{
+	std::string escaped;
+	for (char c : str)
+	{
+		if (c == '\\' || c == '"')
+		{
+			escaped += '\\';
+		}
+		escaped += c;
+	}
+	return escaped;
+}
+
 // adds uncommited transpilation buffer to a transpiled content string after entire
-// line has been checked, and clears buffer
-void TranspiledBuffer::commitLine(bool inProcedure, int currStatementScope)
+// line has been checked, and clears buffer. If line counting is enabled, a line
+// which is a statement will increment the execution counter of its source line
+// (structures count executions of their conditions instead; see lineCountExpr)
+void TranspiledBuffer::commitLine(bool inProcedure, int currStatementScope, bool statement)
 {
 	// determine whether to write new line to inside of main or to global scope (for procedures)
 	std::string& commitTo = inProcedure ? transpiledProcedures : transpiledMain;
 
+	// map the line back to its Sudoh source line; lines generated without a source line of their own (e.g.
+	// closing braces, or the 'return null;' at the end of a procedure) are mapped back to the transpiled file
+	if (!lineDirectiveFile.empty())
+	{
+		bool& mapped = inProcedure ? proceduresMapped : mainMapped;
+		if (sourceLineChanged)
+		{
+			commitTo += "#line " + std::to_string(sourceLine) + " \"" + lineDirectiveFile + "\"\n";
+			sourceLineChanged = false;
+			mapped = true;
+		}
+		else if (mapped)
+		{
+			commitTo += GENERATED_LINE + "\n";
+			mapped = false;
+		}
+	}
+
 	// correctly indent new line
 	for (int i = 0; i < currStatementScope + !inProcedure; i++)
 	{
 		commitTo += "\t";
 	}
+	if (!lineCountFile.empty() && statement)
+	{
+		commitTo += "countLine(" + lineCounter() + "); ";
+	}
 	commitTo += uncommittedTrans + "\n";
 	uncommittedTrans = "";
 }
@@ -21,6 +64,82 @@ void TranspiledBuffer::appendToBuffer(const std::string append)
 	uncommittedTrans += append;
 }
 
+// returns the current length of the uncommitted transpilation buffer, to later take content appended after it
+size_t TranspiledBuffer::bufferPosition()
+{
+	return uncommittedTrans.length();
+}
+
+// removes and returns all content appended to the uncommitted transpilation buffer after a position; used
+// for reordering transpiled content e.g. when an expression must be evaluated before content preceding it
+std::string TranspiledBuffer::takeFromBuffer(size_t position)
+{
+	std::string taken = uncommittedTrans.substr(position);
+	uncommittedTrans.erase(position);
+	return taken;
+}
+
+// appends content to the end of the last committed line
+void TranspiledBuffer::appendToLastLine(bool inProcedure, const std::string append)
+{
+	std::string& committed = inProcedure ? transpiledProcedures : transpiledMain;
+	committed.insert(committed.length() - 1, append);
+}
+
+// enables emitting '#line' directives referring to the specified Sudoh source file, and back to the specified
+// transpiled file for generated lines
+void TranspiledBuffer::enableLineDirectives(const std::string sourceFile, const std::string transpiledFile)
+{
+	lineDirectiveFile = escapeString(sourceFile);
+	this->transpiledFile = escapeString(transpiledFile);
+}
+
+// enables counting executions of each statement line of the specified Sudoh source file
+void TranspiledBuffer::enableLineCounts(const std::string sourceFile)
+{
+	lineCountFile = escapeString(sourceFile);
+}
+
+// returns the execution counter of the current source line, which is then reported on exit; empty if line
+// counting is disabled
+std::string TranspiledBuffer::lineCounter()
+{
+	if (lineCountFile.empty())
+	{
+		return "";
+	}
+	countedLines.insert(sourceLine);
+	return "lineCounts[" + std::to_string(sourceLine) + "]";
+}
+
+// returns an expression (followed by a comma operator) which increments the execution counter of the current
+// source line, to be placed at the beginning of a condition of a structure; empty if line counting is disabled
+std::string TranspiledBuffer::lineCountExpr()
+{
+	std::string counter = lineCounter();
+	return counter.empty() ? "" : "countLine(" + counter + "), ";
+}
+
+// sets the Sudoh source line that the following committed lines were transpiled from
+void TranspiledBuffer::setSourceLine(int line)
+{
+	sourceLine = line;
+	sourceLineChanged = true;
+}
+
+// marks the current position in the procedure definitions as the beginning of a procedure body
+void TranspiledBuffer::markProcedureBegin()
+{
+	procedureBegin = transpiledProcedures.length();
+}
+
+// inserts a line at the beginning of the body of the procedure currently being transpiled; used
+// for content which can only be determined once the entire procedure has been parsed
+void TranspiledBuffer::insertAtProcedureBegin(const std::string line)
+{
+	transpiledProcedures.insert(procedureBegin, "\t" + line + "\n");
+}
+
 void TranspiledBuffer::includeFile(const std::string fileName)
 {
 	transpiledIncludes += "#include \"" + fileName + ".h\"\n";
@@ -28,5 +147,32 @@ void TranspiledBuffer::includeFile(const std::string fileName)
 
 std::string TranspiledBuffer::fullTranspiled(bool main)
 {
-	return transpiledIncludes + "\n" + transpiledProcedures + (main ? transpiledMain : "");
+	// declare the array of line execution counters and register it to be reported on exit
+	std::string lineCountDecls;
+	if (!lineCountFile.empty())
+	{
+		int numLines = countedLines.empty() ? 1 : *countedLines.rbegin() + 1;
+		std::string lines;
+		for (int e : countedLines)
+		{
+			lines += (lines.empty() ? "" : ", ") + std::to_string(e);
+		}
+		lineCountDecls = "\nstatic LineCount lineCounts[" + std::to_string(numLines) + "];\n"
+			"static const int countedLines[] = { " + (lines.empty() ? "0" : lines) + " };\n"
+			"static const LineCounter lineCounter(\"" + lineCountFile + "\", lineCounts, countedLines, " +
+			std::to_string(countedLines.size()) + ");\n";
+	}
+	std::string full = transpiledIncludes + lineCountDecls + "\n" + transpiledProcedures + (main ? transpiledMain : "");
+
+	// a directive (on line n) referring the following lines back to the transpiled file gives the next line
+	// its actual number, n + 1
+	int lineNum = 1;
+	for (size_t pos = 0; pos < full.length(); pos = full.find('\n', pos) + 1, lineNum++)
+	{
+		if (full.compare(pos, GENERATED_LINE.length() + 1, GENERATED_LINE + "\n") == 0)
+		{
+			full.replace(pos, GENERATED_LINE.length(), "#line " + std::to_string(lineNum + 1) + " \"" + transpiledFile + "\"");
+		}
+	}
+	return full;
 }
\ No newline at end of file
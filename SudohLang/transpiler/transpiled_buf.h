@@ -2,6 +2,7 @@
 #define TRANSPILED_BUF_H
 
 #include <string>
+#include <set>
 
 class TranspiledBuffer
 {
@@ -15,9 +16,40 @@ class TranspiledBuffer
 	// buffer string which will be written to one of the above transpiled strings at the end of a line
 	std::string uncommittedTrans;
 
+	// position in transpiledProcedures of the first line of the body of the procedure currently being transpiled
+	size_t procedureBegin;
+
+	// name of the Sudoh source file to refer to in '#line' directives; no directives are emitted if empty
+	std::string lineDirectiveFile;
+	// name of the transpiled file, which lines generated without a Sudoh source line are referred back to
+	std::string transpiledFile;
+	// line of the Sudoh source file which the next committed line was transpiled from
+	int sourceLine;
+	bool sourceLineChanged;
+	// whether the last lines committed to transpiledProcedures/transpiledMain are mapped to the Sudoh source file
+	bool proceduresMapped;
+	bool mainMapped;
+
+	// name of the Sudoh source file whose lines' executions are counted; lines are not counted if empty
+	std::string lineCountFile;
+	// source lines of all statements which have been instrumented to count their executions
+	std::set<int> countedLines;
+
 public:
-	void commitLine(bool inProcedure, int currStatementScope);
+	TranspiledBuffer() : procedureBegin(0), sourceLine(0), sourceLineChanged(false), proceduresMapped(false),
+		mainMapped(false) {}
+	void commitLine(bool inProcedure, int currStatementScope, bool statement = false);
 	void appendToBuffer(const std::string append);
+	size_t bufferPosition();
+	std::string takeFromBuffer(size_t position);
+	void appendToLastLine(bool inProcedure, const std::string append);
+	void enableLineDirectives(const std::string sourceFile, const std::string transpiledFile);
+	void enableLineCounts(const std::string sourceFile);
+	std::string lineCounter();
+	std::string lineCountExpr();
+	void setSourceLine(int line);
+	void markProcedureBegin();
+	void insertAtProcedureBegin(const std::string line);
 	void includeFile(const std::string fileName);
 	std::string fullTranspiled(bool main);
 };